@@ -0,0 +1,255 @@
+#include "batch.hpp"
+#include <qcommandlineoption.h>
+#include <qcommandlineparser.h>
+#include <qcoreapplication.h>
+#include <qnamespace.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qstringliteral.h>
+#include <KLocalizedString>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <opencv2/core/types.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "eyeofsauron_db.h"
+#include "sound_batch.hpp"
+#include "thread_pool.hpp"
+#include "tracker_batch.hpp"
+#include "tracker_engine.hpp"
+#include "trajectory_log.hpp"
+#include "util.hpp"
+
+namespace batch {
+
+auto requested(int argc, char* argv[]) -> bool {
+  for (int n = 1; n < argc; n++) {
+    const auto arg = std::string_view(argv[n]);
+
+    if (arg == "--batch" || arg.starts_with("--batch=")) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto parse_algorithm(const QString& name, int& algorithm) -> bool {
+  for (const auto& info : tracker::engine_infos()) {
+    if (name.compare(QString::fromLatin1(info.name), Qt::CaseInsensitive) == 0) {
+      algorithm = info.algorithm;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto parse_roi(const QString& value, cv::Rect2d& roi) -> bool {
+  std::vector<std::string> fields;
+
+  boost::split(fields, value.toStdString(), boost::is_any_of(","));
+
+  if (fields.size() != 4U) {
+    return false;
+  }
+
+  std::vector<double> numbers(4);
+
+  for (size_t n = 0; n < 4U; n++) {
+    if (!util::str_to_num(fields[n], numbers[n])) {
+      return false;
+    }
+  }
+
+  roi = cv::Rect2d(numbers[0], numbers[1], numbers[2], numbers[3]);
+
+  return roi.width > 0 && roi.height > 0;
+}
+
+auto run_tracker(const QCommandLineParser& parser, int jobs) -> int {
+  tracker::BatchOptions options{.algorithm = db::Main::trackingAlgorithm(),
+                                .jobs = jobs,
+                                .precision = db::Main::tableFilePrecision(),
+                                .engines = tracker::read_engine_settings()};
+
+  const auto algorithm = parser.value(QStringLiteral("algorithm"));
+
+  if (!algorithm.isEmpty() && !parse_algorithm(algorithm, options.algorithm)) {
+    util::critical("Unknown tracking algorithm: " + algorithm.toStdString());
+
+    return 1;
+  }
+
+  for (const auto& value : parser.values(QStringLiteral("roi"))) {
+    cv::Rect2d roi;
+
+    if (!parse_roi(value, roi)) {
+      util::critical("Invalid ROI. The expected format is x,y,width,height: " + value.toStdString());
+
+      return 1;
+    }
+
+    options.rois.push_back(roi);
+  }
+
+  if (options.rois.empty()) {
+    util::critical("At least one --roi is needed");
+
+    return 1;
+  }
+
+  options.output_dir = parser.value(QStringLiteral("output-dir")).toStdString();
+
+  for (const auto& file : parser.positionalArguments()) {
+    options.files.emplace_back(file.toStdString());
+  }
+
+  return tracker::track_files(options) == 0 ? 0 : 1;
+}
+
+auto run_sound(const QCommandLineParser& parser, int jobs) -> int {
+  sound::BatchOptions options{.jobs = jobs,
+                              .precision = db::Main::tableFilePrecision(),
+                              .fft_size = db::Main::fftSize(),
+                              .measure_plans = db::Main::fftMeasurePlans()};
+
+  if (const auto value = parser.value(QStringLiteral("fft-size")).toStdString();
+      !value.empty() && (!util::str_to_num(value, options.fft_size) || options.fft_size < 2)) {
+    util::critical("Invalid FFT size: " + value);
+
+    return 1;
+  }
+
+  double overlap = db::Main::fftOverlap();
+
+  if (const auto value = parser.value(QStringLiteral("overlap")).toStdString();
+      !value.empty() && (!util::str_to_num(value, overlap) || overlap < 0.0 || overlap >= 1.0)) {
+    util::critical("Invalid segment overlap. It must be in the range [0, 1): " + value);
+
+    return 1;
+  }
+
+  options.hop = std::max(static_cast<int>(std::lround(options.fft_size * (1.0 - overlap))), 1);
+
+  options.output_dir = parser.value(QStringLiteral("output-dir")).toStdString();
+
+  for (const auto& file : parser.positionalArguments()) {
+    options.files.emplace_back(file.toStdString());
+  }
+
+  return sound::analyze_files(options) == 0 ? 0 : 1;
+}
+
+auto run_convert(const QCommandLineParser& parser) -> int {
+  const auto format = parser.value(QStringLiteral("format")).toLower();
+
+  if (!format.isEmpty() && format != QStringLiteral("tsv") && format != QStringLiteral("csv")) {
+    util::critical("Unknown table format: " + format.toStdString());
+
+    return 1;
+  }
+
+  const bool csv = format == QStringLiteral("csv");
+
+  const auto output_dir = std::filesystem::path(parser.value(QStringLiteral("output-dir")).toStdString());
+
+  int n_failures = 0;
+
+  for (const auto& file : parser.positionalArguments()) {
+    const auto input = std::filesystem::path(file.toStdString());
+
+    auto output = (output_dir.empty() ? input.parent_path() : output_dir) / input.stem();
+
+    output += csv ? ".csv" : ".tsv";
+
+    if (tracker::convert_trajectory_log(input, output, csv ? ',' : '\t', db::Main::tableFilePrecision())) {
+      util::info(input.string() + " converted to " + output.string());
+    } else {
+      n_failures++;
+    }
+  }
+
+  return n_failures == 0 ? 0 : 1;
+}
+
+auto run(const QCoreApplication& app) -> int {
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription(i18n("Processes recorded files without the graphical interface"));
+  parser.addHelpOption();
+
+  parser.addOptions({
+      {QStringLiteral("batch"), i18n("Analysis to run. Available: track, sound, convert"), QStringLiteral("mode")},
+      {QStringLiteral("roi"), i18n("Region of interest in video pixels. Can be repeated"),
+       QStringLiteral("x,y,width,height")},
+      {QStringLiteral("algorithm"),
+       i18n("Tracking algorithm: kcf, mosse, tld, mil, csrt, nano, vit, dasiamrpn, batchmosse or marker. Defaults to "
+            "the one chosen in the interface"),
+       QStringLiteral("name")},
+      {QStringLiteral("fft-size"), i18n("Samples in each sound segment. Defaults to the value used in the interface"),
+       QStringLiteral("n")},
+      {QStringLiteral("overlap"), i18n("Fraction of overlap between sound segments. Defaults to the interface value"),
+       QStringLiteral("fraction")},
+      {QStringLiteral("format"), i18n("Table format used by convert: tsv or csv. Defaults to tsv"),
+       QStringLiteral("format")},
+      {QStringLiteral("output-dir"),
+       i18n("Directory where the tables are saved. Defaults to the directory of each file"), QStringLiteral("dir")},
+      {QStringLiteral("jobs"), i18n("Number of files processed at the same time. Defaults to the number of cores"),
+       QStringLiteral("n")},
+  });
+
+  parser.addPositionalArgument(QStringLiteral("files"), i18n("Files to process"), QStringLiteral("files..."));
+
+  parser.process(app);
+
+  if (parser.positionalArguments().isEmpty()) {
+    util::critical("No input file was given");
+
+    return 1;
+  }
+
+  const auto output_dir = parser.value(QStringLiteral("output-dir")).toStdString();
+
+  if (!output_dir.empty() && !std::filesystem::is_directory(output_dir)) {
+    util::critical("The output directory does not exist: " + output_dir);
+
+    return 1;
+  }
+
+  int jobs = util::hardware_threads();
+
+  if (const auto value = parser.value(QStringLiteral("jobs")).toStdString();
+      !value.empty() && (!util::str_to_num(value, jobs) || jobs < 1)) {
+    util::critical("Invalid number of jobs: " + value);
+
+    return 1;
+  }
+
+  jobs = std::min(jobs, static_cast<int>(parser.positionalArguments().size()));
+
+  const auto mode = parser.value(QStringLiteral("batch"));
+
+  if (mode == QStringLiteral("track")) {
+    return run_tracker(parser, jobs);
+  }
+
+  if (mode == QStringLiteral("sound")) {
+    return run_sound(parser, jobs);
+  }
+
+  if (mode == QStringLiteral("convert")) {
+    return run_convert(parser);
+  }
+
+  util::critical("Unknown batch mode: " + mode.toStdString());
+
+  return 1;
+}
+
+}  // namespace batch
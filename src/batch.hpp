@@ -0,0 +1,16 @@
+#pragma once
+
+#include <qcoreapplication.h>
+
+namespace batch {
+
+/*
+  Command line mode used to process recorded files without the graphical interface. It is selected with --batch and
+  does not take the single instance lock. So several batch runs can happen while the interface is open.
+*/
+
+auto requested(int argc, char* argv[]) -> bool;
+
+auto run(const QCoreApplication& app) -> int;
+
+}  // namespace batch
@@ -43,6 +43,19 @@ FormCard.FormCardPage {
             }
         }
 
+        EoSSpinBox {
+            label: i18n("Chart Refresh Rate")
+            unit: i18n("Hz")
+            decimals: 0
+            stepSize: 1
+            from: 1
+            to: 240
+            value: EoSdb.chartRefreshRate
+            onValueModified: (v) => {
+                EoSdb.chartRefreshRate = v;
+            }
+        }
+
         EoSSpinBox {
             label: i18n("Table File Precision")
             decimals: 0
@@ -69,7 +82,7 @@ FormCard.FormCardPage {
             displayMode: FormCard.FormComboBoxDelegate.ComboBox
             currentIndex: EoSdb.trackingAlgorithm
             editable: false
-            model: ["KCF", "MOSSE", "TLD", "MIL"]
+            model: ["KCF", "MOSSE", "TLD", "MIL", "CSRT", "Nano", "Vit", "DaSiamRPN", "Batch MOSSE", "Color Marker"]
             onActivated: (idx) => {
                 if (idx !== EoSdb.trackingAlgorithm)
                     EoSdb.trackingAlgorithm = idx;
@@ -77,6 +90,129 @@ FormCard.FormCardPage {
             }
         }
 
+        EoSSpinBox {
+            label: i18n("Marker Hue Tolerance")
+            visible: EoSdb.trackingAlgorithm === 9
+            decimals: 0
+            stepSize: 1
+            from: 1
+            to: 90
+            value: EoSdb.markerHueTolerance
+            onValueModified: (v) => {
+                EoSdb.markerHueTolerance = v;
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Marker Minimum Saturation")
+            visible: EoSdb.trackingAlgorithm === 9
+            decimals: 0
+            stepSize: 5
+            from: 0
+            to: 255
+            value: EoSdb.markerMinSaturation
+            onValueModified: (v) => {
+                EoSdb.markerMinSaturation = v;
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Marker Minimum Brightness")
+            visible: EoSdb.trackingAlgorithm === 9
+            decimals: 0
+            stepSize: 5
+            from: 0
+            to: 255
+            value: EoSdb.markerMinValue
+            onValueModified: (v) => {
+                EoSdb.markerMinValue = v;
+            }
+        }
+
+        FormCard.FormTextFieldDelegate {
+            label: i18n("Nano Backbone Network")
+            placeholderText: i18n("Path to the .onnx file")
+            visible: EoSdb.trackingAlgorithm === 5
+            text: EoSdb.nanoBackbonePath
+            onEditingFinished: {
+                if (text !== EoSdb.nanoBackbonePath)
+                    EoSdb.nanoBackbonePath = text;
+
+            }
+        }
+
+        FormCard.FormTextFieldDelegate {
+            label: i18n("Nano Neck and Head Network")
+            placeholderText: i18n("Path to the .onnx file")
+            visible: EoSdb.trackingAlgorithm === 5
+            text: EoSdb.nanoNeckheadPath
+            onEditingFinished: {
+                if (text !== EoSdb.nanoNeckheadPath)
+                    EoSdb.nanoNeckheadPath = text;
+
+            }
+        }
+
+        FormCard.FormTextFieldDelegate {
+            label: i18n("Vit Network")
+            placeholderText: i18n("Path to the .onnx file")
+            visible: EoSdb.trackingAlgorithm === 6
+            text: EoSdb.vitModelPath
+            onEditingFinished: {
+                if (text !== EoSdb.vitModelPath)
+                    EoSdb.vitModelPath = text;
+
+            }
+        }
+
+        FormCard.FormTextFieldDelegate {
+            label: i18n("DaSiamRPN Network")
+            placeholderText: i18n("Path to the .onnx file")
+            visible: EoSdb.trackingAlgorithm === 7
+            text: EoSdb.dasiamrpnModelPath
+            onEditingFinished: {
+                if (text !== EoSdb.dasiamrpnModelPath)
+                    EoSdb.dasiamrpnModelPath = text;
+
+            }
+        }
+
+        FormCard.FormTextFieldDelegate {
+            label: i18n("DaSiamRPN Classification Kernel")
+            placeholderText: i18n("Path to the .onnx file")
+            visible: EoSdb.trackingAlgorithm === 7
+            text: EoSdb.dasiamrpnKernelCls1Path
+            onEditingFinished: {
+                if (text !== EoSdb.dasiamrpnKernelCls1Path)
+                    EoSdb.dasiamrpnKernelCls1Path = text;
+
+            }
+        }
+
+        FormCard.FormTextFieldDelegate {
+            label: i18n("DaSiamRPN Regression Kernel")
+            placeholderText: i18n("Path to the .onnx file")
+            visible: EoSdb.trackingAlgorithm === 7
+            text: EoSdb.dasiamrpnKernelR1Path
+            onEditingFinished: {
+                if (text !== EoSdb.dasiamrpnKernelR1Path)
+                    EoSdb.dasiamrpnKernelR1Path = text;
+
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Tracker Threads (0 = Automatic)")
+            decimals: 0
+            stepSize: 1
+            from: 0
+            to: 64
+            value: EoSdb.trackerThreads
+            onValueModified: (v) => {
+                EoSdb.trackerThreads = v;
+            }
+        }
+
         FormCard.FormComboBoxDelegate {
             id: imageScalingAlgorithm
 
@@ -92,6 +228,63 @@ FormCard.FormCardPage {
             }
         }
 
+        FormCard.FormComboBoxDelegate {
+            id: trackingResolution
+
+            text: i18n("Tracking Resolution")
+            displayMode: FormCard.FormComboBoxDelegate.ComboBox
+            currentIndex: EoSdb.trackingResolution
+            editable: false
+            model: [i18n("Native"), i18n("Half"), i18n("Preview")]
+            onActivated: (idx) => {
+                if (idx !== EoSdb.trackingResolution)
+                    EoSdb.trackingResolution = idx;
+
+            }
+        }
+
+        FormCard.FormComboBoxDelegate {
+            id: videoDecoder
+
+            text: i18n("Media File Decoder")
+            displayMode: FormCard.FormComboBoxDelegate.ComboBox
+            currentIndex: EoSdb.videoDecoder
+            editable: false
+            model: ["Qt Multimedia", "FFmpeg"]
+            onActivated: (idx) => {
+                if (idx !== EoSdb.videoDecoder)
+                    EoSdb.videoDecoder = idx;
+
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Decoded Frame Cache")
+            unit: i18n("MiB")
+            decimals: 0
+            stepSize: 64
+            from: 0
+            to: 16384
+            value: EoSdb.frameCacheSize
+            onValueModified: (v) => {
+                EoSdb.frameCacheSize = v;
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Frames Tracked Back for New ROIs")
+            unit: i18n("frames")
+            decimals: 0
+            stepSize: 10
+            from: 0
+            to: 1000
+            value: EoSdb.retrackFrames
+            statusMessage: i18n("The frames kept are not sharper than the preview. When the tracking resolution is higher, new ROIs lose precision when they are handed over to the live frames. Each frame takes as much memory as the preview in gray, three times as much for the algorithms using color: about 6 MiB for a 1080p preview.")
+            onValueModified: (v) => {
+                EoSdb.retrackFrames = v;
+            }
+        }
+
         EoSSwitch {
             id: showDateTime
 
@@ -116,6 +309,18 @@ FormCard.FormCardPage {
             }
         }
 
+        EoSSwitch {
+            id: continuousLogging
+
+            label: i18n("Log Every Tracked Position to the Documents Folder")
+            isChecked: EoSdb.continuousLogging
+            onCheckedChanged: {
+                if (isChecked !== EoSdb.continuousLogging)
+                    EoSdb.continuousLogging = isChecked;
+
+            }
+        }
+
         EoSSpinBox {
             label: i18n("Video Width")
             unit: i18n("px")
@@ -144,4 +349,105 @@ FormCard.FormCardPage {
 
     }
 
+    FormCard.FormHeader {
+        title: i18n("Sound Wave")
+    }
+
+    FormCard.FormCard {
+        FormCard.FormComboBoxDelegate {
+            id: mediaFilePacing
+
+            text: i18n("Media File Playback")
+            displayMode: FormCard.FormComboBoxDelegate.ComboBox
+            currentIndex: EoSdb.mediaFilePacing
+            editable: false
+            model: [i18n("Realtime"), i18n("As Fast as Possible")]
+            onActivated: (idx) => {
+                if (idx !== EoSdb.mediaFilePacing)
+                    EoSdb.mediaFilePacing = idx;
+
+            }
+        }
+
+        FormCard.FormComboBoxDelegate {
+            id: spectrumMethod
+
+            text: i18n("Spectrum Method")
+            displayMode: FormCard.FormComboBoxDelegate.ComboBox
+            currentIndex: EoSdb.spectrumMethod
+            editable: false
+            model: [i18n("Whole Time Window"), i18n("Welch")]
+            onActivated: (idx) => {
+                if (idx !== EoSdb.spectrumMethod)
+                    EoSdb.spectrumMethod = idx;
+
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("FFT Size")
+            unit: i18n("samples")
+            enabled: EoSdb.spectrumMethod === 1
+            decimals: 0
+            stepSize: 1
+            from: 64
+            to: 65536
+            value: EoSdb.fftSize
+            onValueModified: (v) => {
+                EoSdb.fftSize = v;
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Segment Overlap")
+            enabled: EoSdb.spectrumMethod === 1
+            decimals: 2
+            stepSize: 0.05
+            from: 0
+            to: 0.95
+            value: EoSdb.fftOverlap
+            onValueModified: (v) => {
+                EoSdb.fftOverlap = v;
+            }
+        }
+
+        EoSSpinBox {
+            label: i18n("Averaged Segments")
+            enabled: EoSdb.spectrumMethod === 1
+            decimals: 0
+            stepSize: 1
+            from: 1
+            to: 256
+            value: EoSdb.welchSegments
+            onValueModified: (v) => {
+                EoSdb.welchSegments = v;
+            }
+        }
+
+        EoSSwitch {
+            id: fftMeasurePlans
+
+            label: i18n("Measure the FFT Plans")
+            isChecked: EoSdb.fftMeasurePlans
+            onCheckedChanged: {
+                if (isChecked !== EoSdb.fftMeasurePlans)
+                    EoSdb.fftMeasurePlans = isChecked;
+
+            }
+        }
+
+        EoSSwitch {
+            id: recordAudio
+
+            label: i18n("Record the Analyzed Audio to the Documents Folder")
+            isChecked: EoSdb.recordAudio
+            onCheckedChanged: {
+                if (isChecked !== EoSdb.recordAudio)
+                    EoSdb.recordAudio = isChecked;
+
+            }
+        }
+
+    }
+
 }
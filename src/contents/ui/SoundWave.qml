@@ -48,9 +48,13 @@ Kirigami.ScrollablePage {
     }
 
     Connections {
-        function onUpdateChart() {
-            EoSSoundBackend.updateSeriesWaveform(chartWaveForm.series(0));
-            EoSSoundBackend.updateSeriesFFT(chartFFT.series(0));
+        function onUpdateChart(waveformChanged, spectrumChanged) {
+            if (waveformChanged)
+                EoSSoundBackend.updateSeriesWaveform(chartWaveForm.series(0));
+
+            if (spectrumChanged)
+                EoSSoundBackend.updateSeriesFFT(chartFFT.series(0));
+
         }
 
         target: EoSSoundBackend
@@ -97,6 +101,14 @@ Kirigami.ScrollablePage {
                 wrapMode: Text.NoWrap
             }
 
+            Controls.Label {
+                Layout.alignment: Qt.AlignHCenter
+                text: i18n("Overruns: %1, Dropped Samples: %2", EoSSoundBackend.overrunEvents, EoSSoundBackend.overrunSamples)
+                color: Kirigami.Theme.disabledTextColor
+                elide: Text.ElideRight
+                wrapMode: Text.NoWrap
+            }
+
             RowLayout {
                 ColumnLayout {
                     ChartView {
@@ -109,6 +121,9 @@ Kirigami.ScrollablePage {
                         antialiasing: true
                         theme: EoSdb.darkChartTheme === true ? ChartView.ChartThemeDark : ChartView.ChartThemeLight
                         localizeNumbers: true
+                        onPlotAreaChanged: {
+                            EoSSoundBackend.setWaveformChartWidth(plotArea.width);
+                        }
 
                         ValueAxis {
                             id: axisTime
@@ -178,6 +193,9 @@ Kirigami.ScrollablePage {
                         antialiasing: true
                         theme: EoSdb.darkChartTheme === true ? ChartView.ChartThemeDark : ChartView.ChartThemeLight
                         localizeNumbers: true
+                        onPlotAreaChanged: {
+                            EoSSoundBackend.setSpectrumChartWidth(plotArea.width);
+                        }
 
                         LogValueAxis {
                             id: axisFreq
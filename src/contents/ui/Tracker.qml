@@ -40,9 +40,12 @@ Kirigami.ScrollablePage {
     ]
 
     Connections {
-        function onUpdateChart() {
+        function onUpdateChart(dirtySeries) {
             for (let n = 0; n < chart.count; n += 2) {
-                EoSTrackerBackend.updateSeries(chart.series(n), chart.series(n + 1), Math.floor(n / 2));
+                let index = Math.floor(n / 2);
+                if (index < dirtySeries.length && dirtySeries[index])
+                    EoSTrackerBackend.updateSeries(chart.series(n), chart.series(n + 1), index);
+
             }
         }
 
@@ -180,6 +183,21 @@ Kirigami.ScrollablePage {
                     wrapMode: Text.NoWrap
                 }
 
+                Controls.Label {
+                    text: i18n("Dropped Frames: %1, Queue: %2, Frame Allocations: %3/s", EoSTrackerBackend.droppedFrames, EoSTrackerBackend.queueDepth, EoSTrackerBackend.frameAllocations)
+                    color: Kirigami.Theme.disabledTextColor
+                    elide: Text.ElideRight
+                    wrapMode: Text.NoWrap
+                }
+
+                Controls.Label {
+                    text: i18n("Tracker Update: %1", EoSTrackerBackend.engineTimings)
+                    visible: EoSTrackerBackend.engineTimings !== ""
+                    color: Kirigami.Theme.disabledTextColor
+                    elide: Text.ElideRight
+                    wrapMode: Text.NoWrap
+                }
+
             }
 
             ColumnLayout {
@@ -209,6 +227,9 @@ Kirigami.ScrollablePage {
                     implicitWidth: 640
                     theme: EoSdb.darkChartTheme === true ? ChartView.ChartThemeDark : ChartView.ChartThemeLight
                     localizeNumbers: true
+                    onPlotAreaChanged: {
+                        EoSTrackerBackend.setChartWidth(plotArea.width);
+                    }
 
                     ValueAxis {
                         id: axisPosition
@@ -273,6 +294,15 @@ Kirigami.ScrollablePage {
                 }
             }
 
+            Controls.ToolButton {
+                icon.name: "media-skip-backward-symbolic"
+                display: Controls.AbstractButton.IconOnly
+                text: i18n("Previous Frame")
+                onClicked: EoSTrackerBackend.stepFrame(-1)
+                Controls.ToolTip.text: text
+                Controls.ToolTip.visible: hovered
+            }
+
             Controls.Slider {
                 id: playerSlider
 
@@ -282,6 +312,15 @@ Kirigami.ScrollablePage {
                 onMoved: EoSTrackerBackend.setPlayerPosition(value * EoSTrackerBackend.playerDuration)
             }
 
+            Controls.ToolButton {
+                icon.name: "media-skip-forward-symbolic"
+                display: Controls.AbstractButton.IconOnly
+                text: i18n("Next Frame")
+                onClicked: EoSTrackerBackend.stepFrame(1)
+                Controls.ToolTip.text: text
+                Controls.ToolTip.visible: hovered
+            }
+
             Text {
                 horizontalAlignment: Text.AlignRight
                 color: Kirigami.Theme.textColor
@@ -306,7 +345,7 @@ Kirigami.ScrollablePage {
                     decimals: 0
                     stepSize: 1
                     from: 2
-                    to: 1000
+                    to: 100000
                     value: EoSdb.chartDataPoints
                     onValueModified: (v) => {
                         EoSdb.chartDataPoints = v;
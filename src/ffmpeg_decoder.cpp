@@ -0,0 +1,561 @@
+#include "ffmpeg_decoder.hpp"
+#include <qsize.h>
+#include <qtypes.h>
+#include <qvideoframeformat.h>
+#include <QVideoFrame>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "config.h"
+#include "frame_cache.hpp"
+#include "util.hpp"
+
+#ifdef HAVE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/rational.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace tracker {
+
+FFmpegDecoder::FFmpegDecoder(std::function<void(const QVideoFrame&)> frame_callback,
+                             std::function<void(qint64)> position_callback)
+    : frames(QVideoFrameFormat::Format_BGRX8888, 8),
+      frame_callback(std::move(frame_callback)),
+      position_callback(std::move(position_callback)) {}
+
+FFmpegDecoder::~FFmpegDecoder() {
+  close();
+}
+
+void FFmpegDecoder::close() {
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    running = false;
+  }
+
+  state_cv.notify_all();
+
+  if (worker.joinable()) {
+    worker.join();
+  }
+
+  close_input();
+}
+
+void FFmpegDecoder::play() {
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    // like QMediaPlayer a file that played until its end starts again from the beginning
+
+    if (at_end) {
+      at_end = false;
+      seek_target_us = 0;
+      show_seek_frame = false;
+    }
+
+    playing = true;
+    reset_clock = true;
+  }
+
+  state_cv.notify_all();
+}
+
+void FFmpegDecoder::pause() {
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    playing = false;
+  }
+
+  state_cv.notify_all();
+}
+
+void FFmpegDecoder::stop() {
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    playing = false;
+    at_end = false;
+    step_request = 0;
+    seek_target_us = 0;
+    show_seek_frame = false;
+  }
+
+  state_cv.notify_all();
+}
+
+void FFmpegDecoder::seek(qint64 position_ms) {
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    at_end = false;
+    step_request = 0;
+    seek_target_us = std::max<qint64>(position_ms, 0) * 1000;
+    show_seek_frame = true;  // the new position is shown even while paused
+  }
+
+  state_cv.notify_all();
+}
+
+void FFmpegDecoder::step(int n_frames) {
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    if (playing) {
+      return;
+    }
+
+    step_request += n_frames;
+  }
+
+  state_cv.notify_all();
+}
+
+void FFmpegDecoder::set_cache_budget(size_t bytes) {
+  std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+  cache_budget = bytes;
+}
+
+void FFmpegDecoder::set_output(const QSize& size, bool nearest) {
+  std::lock_guard<std::mutex> output_lock_guard(output_mutex);
+
+  output_size = size;
+  output_nearest = nearest;
+}
+
+auto FFmpegDecoder::is_open() const -> bool {
+  return format_ctx != nullptr;
+}
+
+auto FFmpegDecoder::duration() const -> qint64 {
+  return duration_ms;
+}
+
+void FFmpegDecoder::deliver(const QVideoFrame& video_frame, std::unique_lock<std::mutex>& lock) {
+  shown_pts_us = video_frame.startTime();
+
+  lock.unlock();
+
+  frame_callback(video_frame);
+
+  position_callback(shown_pts_us / 1000);
+
+  lock.lock();
+}
+
+void FFmpegDecoder::work() {
+  std::unique_lock<std::mutex> lock(state_mutex);
+
+  auto clock_start = std::chrono::steady_clock::now();
+
+  qint64 clock_pts_us = 0;
+
+  bool show_next = false;
+
+  while (true) {
+    state_cv.wait(lock, [&] { return !running || playing || seek_target_us >= 0 || step_request != 0 || show_next; });
+
+    if (!running) {
+      break;
+    }
+
+    cache.set_budget(cache_budget);
+
+    if (step_request != 0) {
+      const auto n = std::exchange(step_request, 0);
+
+      if (playing || shown_pts_us < 0) {
+        continue;
+      }
+
+      auto cached = (n == 1) ? cache.next(shown_pts_us) : (n == -1) ? cache.previous(shown_pts_us) : QVideoFrame();
+
+      if (cached.isValid()) {
+        resync = true;
+
+        deliver(cached, lock);
+
+        continue;
+      }
+
+      if (n == 1 && decoded_pts_us == shown_pts_us) {
+        // the decoder is already positioned right after the frame on screen
+
+        show_next = true;
+
+        continue;
+      }
+
+      // aiming at the middle of the wanted frame makes the search immune to timestamp rounding
+
+      seek_target_us = std::max<qint64>(shown_pts_us + n * frame_duration_us + frame_duration_us / 2, 0);
+      show_seek_frame = true;
+    }
+
+    if (seek_target_us >= 0) {
+      const auto target = std::exchange(seek_target_us, -1);
+
+      reset_clock = true;
+
+      if (!playing && show_seek_frame) {
+        if (auto cached = cache.find(target); cached.isValid()) {
+          resync = true;
+
+          deliver(cached, lock);
+
+          continue;
+        }
+      }
+
+      seek_input(target);
+
+      show_next = show_seek_frame;
+
+      continue;
+    }
+
+    if (std::exchange(resync, false) && decoded_pts_us != shown_pts_us) {
+      // continuing after a frame that came from the cache
+
+      seek_input(shown_pts_us + frame_duration_us + frame_duration_us / 2);
+    }
+
+    lock.unlock();
+
+    const bool decoded = decode_frame();
+
+    lock.lock();
+
+    if (!decoded) {
+      // end of the file or a broken stream
+
+      playing = false;
+      at_end = true;
+      show_next = false;
+
+      continue;
+    }
+
+    const auto pts_us = frame_time_us();
+
+    decoded_pts_us = pts_us;
+
+    if (pts_us + frame_duration_us <= skip_until_us) {
+      // The seek landed on the keyframe before the requested position. While paused the frames in between are
+      // likely to be stepped through next, so they are cached.
+
+      if (!playing && cache_budget > 0U) {
+        cache.insert(convert_frame(pts_us, false));
+      }
+
+      continue;
+    }
+
+    if (reset_clock) {
+      clock_start = std::chrono::steady_clock::now();
+      clock_pts_us = pts_us;
+      reset_clock = false;
+    }
+
+    if (playing) {
+      const auto due = clock_start + std::chrono::microseconds(pts_us - clock_pts_us);
+
+      // pause, stop and seek requests interrupt the wait. The frame is dropped in this case
+
+      if (state_cv.wait_until(lock, due, [&] { return !running || !playing || seek_target_us >= 0; })) {
+        continue;
+      }
+    }
+
+    show_next = false;
+
+    // Frames shown during playback come from the recycled pool. The ones shown while paused are worth caching.
+
+    const bool paused = !playing;
+
+    auto video_frame = convert_frame(pts_us, !paused);
+
+    if (!video_frame.isValid()) {
+      continue;
+    }
+
+    if (paused) {
+      cache.insert(video_frame);
+    }
+
+    deliver(video_frame, lock);
+  }
+}
+
+#ifdef HAVE_FFMPEG
+
+auto FFmpegDecoder::available() -> bool {
+  return true;
+}
+
+auto FFmpegDecoder::open(const std::string& path) -> bool {
+  close();
+
+  auto fail = [&](const std::string& msg) {
+    util::warning("ffmpeg: " + msg + ": " + path);
+
+    close_input();
+
+    return false;
+  };
+
+  if (avformat_open_input(&format_ctx, path.c_str(), nullptr, nullptr) < 0) {
+    return fail("could not open the file");
+  }
+
+  if (avformat_find_stream_info(format_ctx, nullptr) < 0) {
+    return fail("could not read the stream information");
+  }
+
+  const AVCodec* codec = nullptr;
+
+  stream_index = av_find_best_stream(format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+
+  if (stream_index < 0 || codec == nullptr) {
+    return fail("no supported video stream");
+  }
+
+  const auto* stream = format_ctx->streams[stream_index];
+
+  codec_ctx = avcodec_alloc_context3(codec);
+
+  if (codec_ctx == nullptr || avcodec_parameters_to_context(codec_ctx, stream->codecpar) < 0) {
+    return fail("could not configure the decoder");
+  }
+
+  // Frame threading decodes several pictures at the same time. A thread count of 0 means one thread per core.
+
+  codec_ctx->thread_count = 0;
+  codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+  if (avcodec_open2(codec_ctx, codec, nullptr) < 0) {
+    return fail("could not open the decoder");
+  }
+
+  packet = av_packet_alloc();
+  frame = av_frame_alloc();
+
+  if (packet == nullptr || frame == nullptr) {
+    return fail("out of memory");
+  }
+
+  start_time = (stream->start_time == AV_NOPTS_VALUE) ? 0 : stream->start_time;
+
+  duration_ms = (format_ctx->duration == AV_NOPTS_VALUE) ? 0 : format_ctx->duration / (AV_TIME_BASE / 1000);
+
+  frame_duration_us = (stream->avg_frame_rate.num > 0)
+                          ? av_rescale_q(1, av_inv_q(stream->avg_frame_rate), AVRational{1, 1000000})
+                          : 40000;
+
+  skip_until_us = 0;
+  shown_pts_us = -1;
+  decoded_pts_us = -1;
+  resync = false;
+
+  cache.clear();
+
+  {
+    std::lock_guard<std::mutex> state_lock_guard(state_mutex);
+
+    running = true;
+    playing = false;
+    at_end = false;
+    reset_clock = true;
+    step_request = 0;
+    seek_target_us = -1;
+  }
+
+  worker = std::thread(&FFmpegDecoder::work, this);
+
+  return true;
+}
+
+void FFmpegDecoder::close_input() {
+  sws_freeContext(sws_ctx);
+
+  sws_ctx = nullptr;
+
+  av_frame_free(&frame);
+  av_packet_free(&packet);
+  avcodec_free_context(&codec_ctx);
+  avformat_close_input(&format_ctx);
+
+  stream_index = -1;
+  duration_ms = 0;
+}
+
+void FFmpegDecoder::seek_input(qint64 position_us) {
+  const auto* stream = format_ctx->streams[stream_index];
+
+  const auto ts = start_time + av_rescale_q(position_us, AVRational{1, 1000000}, stream->time_base);
+
+  // the demuxer goes to the keyframe at or before the position. The decoding loop skips the frames until there
+
+  if (av_seek_frame(format_ctx, stream_index, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+    util::warning("ffmpeg: seek to " + util::to_string(position_us) + " us failed");
+  }
+
+  avcodec_flush_buffers(codec_ctx);
+
+  skip_until_us = position_us;
+  decoded_pts_us = -1;
+  resync = false;
+}
+
+auto FFmpegDecoder::decode_frame() -> bool {
+  while (true) {
+    const int status = avcodec_receive_frame(codec_ctx, frame);
+
+    if (status == 0) {
+      return true;
+    }
+
+    if (status != AVERROR(EAGAIN)) {
+      return false;  // AVERROR_EOF once the decoder was drained
+    }
+
+    if (av_read_frame(format_ctx, packet) < 0) {
+      // no more packets. Sending an empty one makes the decoder output the pictures it still holds
+
+      avcodec_send_packet(codec_ctx, nullptr);
+
+      continue;
+    }
+
+    if (packet->stream_index == stream_index) {
+      avcodec_send_packet(codec_ctx, packet);
+    }
+
+    av_packet_unref(packet);
+  }
+}
+
+auto FFmpegDecoder::frame_time_us() const -> qint64 {
+  const auto* stream = format_ctx->streams[stream_index];
+
+  const auto ts = (frame->best_effort_timestamp != AV_NOPTS_VALUE) ? frame->best_effort_timestamp : frame->pts;
+
+  if (ts == AV_NOPTS_VALUE) {
+    return skip_until_us;
+  }
+
+  return av_rescale_q(ts - start_time, stream->time_base, AVRational{1, 1000000});
+}
+
+auto FFmpegDecoder::convert_frame(qint64 pts_us, bool pooled) -> QVideoFrame {
+  QSize size;
+
+  bool nearest = false;
+
+  {
+    std::lock_guard<std::mutex> output_lock_guard(output_mutex);
+
+    size = output_size;
+    nearest = output_nearest;
+  }
+
+  if (!size.isValid()) {
+    size = QSize(frame->width, frame->height);  // the frames keep their native resolution
+  }
+
+  if (size != cached_size || nearest != cached_nearest) {
+    cache.clear();
+
+    cached_size = size;
+    cached_nearest = nearest;
+  }
+
+  // Cached frames must own their memory. The pool recycles its frames after a few others were acquired.
+
+  QVideoFrame video_frame;
+
+  if (pooled) {
+    video_frame = frames.acquire(size);
+  } else {
+    auto video_format = QVideoFrameFormat(size, QVideoFrameFormat::Format_BGRX8888);
+
+    video_format.setColorRange(QVideoFrameFormat::ColorRange_Full);
+
+    video_frame = QVideoFrame(video_format);
+  }
+
+  if (!video_frame.isValid() || !video_frame.map(QVideoFrame::WriteOnly)) {
+    return {};
+  }
+
+  // Scaling and color conversion in one pass. The context is only rebuilt when the sizes or the formats change.
+
+  sws_ctx = sws_getCachedContext(sws_ctx, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                 size.width(), size.height(), AV_PIX_FMT_BGR0, nearest ? SWS_POINT : SWS_AREA,
+                                 nullptr, nullptr, nullptr);
+
+  if (sws_ctx == nullptr) {
+    video_frame.unmap();
+
+    return {};
+  }
+
+  uint8_t* dst_data[4] = {video_frame.bits(0), nullptr, nullptr, nullptr};
+
+  int dst_linesize[4] = {video_frame.bytesPerLine(0), 0, 0, 0};
+
+  sws_scale(sws_ctx, frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize);
+
+  video_frame.unmap();
+
+  video_frame.setStartTime(pts_us);
+  video_frame.setEndTime(pts_us + frame_duration_us);
+
+  return video_frame;
+}
+
+#else
+
+auto FFmpegDecoder::available() -> bool {
+  return false;
+}
+
+auto FFmpegDecoder::open(const std::string& path) -> bool {
+  util::warning("built without FFmpeg support. Using QMediaPlayer for: " + path);
+
+  return false;
+}
+
+void FFmpegDecoder::close_input() {}
+
+void FFmpegDecoder::seek_input(qint64 /*position_us*/) {}
+
+auto FFmpegDecoder::decode_frame() -> bool {
+  return false;
+}
+
+auto FFmpegDecoder::frame_time_us() const -> qint64 {
+  return 0;
+}
+
+auto FFmpegDecoder::convert_frame(qint64 /*pts_us*/, bool /*pooled*/) -> QVideoFrame {
+  return {};
+}
+
+#endif
+
+}  // namespace tracker
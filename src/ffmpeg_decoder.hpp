@@ -0,0 +1,131 @@
+#pragma once
+
+#include <qsize.h>
+#include <qtypes.h>
+#include <QVideoFrame>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "frame_cache.hpp"
+#include "video_frame_pool.hpp"
+
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace tracker {
+
+/*
+  Media file decoder built directly on FFmpeg. The codec decodes on several threads and swscale scales and converts
+  every picture to BGRX at the preview size in a single pass, so the frame ingest only has to drop the padding byte.
+  A worker thread hands the frames to the callback at the pace given by their timestamps. When the program is built
+  without FFmpeg open() always fails and the caller keeps using QMediaPlayer.
+
+  Seeks are frame accurate: the frames between the preceding keyframe and the requested position are decoded and
+  the one covering the position is shown. While paused the decoded frames are kept in a cache, so stepping and
+  scrubbing back and forth around a position does not go back to the keyframe every time.
+*/
+
+class FFmpegDecoder {
+ public:
+  FFmpegDecoder(std::function<void(const QVideoFrame&)> frame_callback,
+                std::function<void(qint64)> position_callback);
+
+  FFmpegDecoder(const FFmpegDecoder&) = delete;
+  auto operator=(const FFmpegDecoder&) -> FFmpegDecoder& = delete;
+
+  ~FFmpegDecoder();
+
+  static auto available() -> bool;
+
+  auto open(const std::string& path) -> bool;
+
+  void close();
+
+  void play();
+
+  void pause();
+
+  void stop();
+
+  void seek(qint64 position_ms);
+
+  // shows the frame n_frames after (or before when negative) the current one. Only while paused
+
+  void step(int n_frames);
+
+  void set_cache_budget(size_t bytes);
+
+  // an invalid size keeps the native resolution of the video
+
+  void set_output(const QSize& size, bool nearest);
+
+  [[nodiscard]] auto is_open() const -> bool;
+
+  [[nodiscard]] auto duration() const -> qint64;  // milliseconds
+
+ private:
+  bool running = false;
+  bool playing = false;
+  bool reset_clock = true;
+  bool at_end = false;
+  bool show_seek_frame = false;
+  bool output_nearest = false;
+  bool cached_nearest = false;
+
+  bool resync = false;  // a cached frame was shown and the decoder is not positioned after it
+
+  int stream_index = -1;
+  int step_request = 0;
+
+  size_t cache_budget = 0;
+
+  qint64 duration_ms = 0;
+  qint64 seek_target_us = -1;  // negative when no seek is pending
+  qint64 skip_until_us = 0;    // frames ending before this timestamp are not shown
+  qint64 frame_duration_us = 40000;
+  qint64 start_time = 0;  // stream time base
+  qint64 shown_pts_us = -1;
+  qint64 decoded_pts_us = -1;
+
+  QSize output_size = {800, 600};
+  QSize cached_size;  // output size of the frames in the cache
+
+  AVFormatContext* format_ctx = nullptr;
+  AVCodecContext* codec_ctx = nullptr;
+  AVPacket* packet = nullptr;
+  AVFrame* frame = nullptr;
+  SwsContext* sws_ctx = nullptr;
+
+  // The pipeline holds at most two frames, the queued one and the one being tracked. The ring is deeper so that the
+  // decoder does not write over them while they are in use.
+
+  VideoFramePool frames;
+
+  FrameCache cache;  // only used by the worker thread
+
+  std::function<void(const QVideoFrame&)> frame_callback;
+  std::function<void(qint64)> position_callback;
+
+  std::mutex state_mutex;
+  std::mutex output_mutex;
+
+  std::condition_variable state_cv;
+
+  std::thread worker;
+
+  void work();
+  void close_input();
+  void seek_input(qint64 position_us);
+  void deliver(const QVideoFrame& video_frame, std::unique_lock<std::mutex>& lock);
+  auto decode_frame() -> bool;
+  auto frame_time_us() const -> qint64;
+  auto convert_frame(qint64 pts_us, bool pooled) -> QVideoFrame;
+};
+
+}  // namespace tracker
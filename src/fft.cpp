@@ -0,0 +1,269 @@
+#include "fft.hpp"
+#include <fftw3.h>
+#include <qstandardpaths.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <numbers>
+#include <span>
+#include <string>
+#include "util.hpp"
+
+namespace sound {
+
+auto fftw_planner_mutex() -> std::mutex& {
+  static std::mutex planner_mutex;
+
+  return planner_mutex;
+}
+
+auto wisdom_file_path() -> std::filesystem::path {
+  return std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation).toStdString()) /
+         "fftw_wisdom";
+}
+
+FFTPlan::FFTPlan(int size, unsigned planner_flags)
+    : size(size), planner_flags(planner_flags), hann_window(static_cast<size_t>(size)) {
+  real_input = fftw_alloc_real(static_cast<size_t>(size));
+  complex_output = fftw_alloc_complex((static_cast<size_t>(size) / 2U) + 1U);
+
+  {
+    std::lock_guard<std::mutex> planner_lock_guard(fftw_planner_mutex());
+
+    // FFTW_MEASURE overwrites the input array. It is filled only after the plan is ready.
+
+    plan = fftw_plan_dft_r2c_1d(size, real_input, complex_output, planner_flags);
+  }
+
+  // https://en.wikipedia.org/wiki/Hann_function
+
+  for (size_t n = 0U; n < hann_window.size(); n++) {
+    hann_window[n] = (size > 1) ? 0.5 * (1.0 - std::cos(2.0 * std::numbers::pi * static_cast<double>(n) /
+                                                        static_cast<double>(size - 1)))
+                                : 1.0;
+  }
+}
+
+FFTPlan::~FFTPlan() {
+  {
+    std::lock_guard<std::mutex> planner_lock_guard(fftw_planner_mutex());
+
+    if (plan != nullptr) {
+      fftw_destroy_plan(plan);
+    }
+  }
+
+  fftw_free(real_input);
+  fftw_free(complex_output);
+}
+
+auto FFTPlan::input() -> std::span<double> {
+  return {real_input, static_cast<size_t>(size)};
+}
+
+auto FFTPlan::output() const -> std::span<const fftw_complex> {
+  return {complex_output, (static_cast<size_t>(size) / 2U) + 1U};
+}
+
+auto FFTPlan::window() const -> std::span<const double> {
+  return hann_window;
+}
+
+void FFTPlan::execute() {
+  fftw_execute(plan);
+}
+
+FFTPlanCache::FFTPlanCache(size_t max_plans) : max_plans(max_plans) {
+  std::lock_guard<std::mutex> planner_lock_guard(fftw_planner_mutex());
+
+  if (auto path = wisdom_file_path(); std::filesystem::exists(path)) {
+    if (fftw_import_wisdom_from_filename(path.c_str()) == 0) {
+      util::warning("failed to import the fftw wisdom from: " + path.string());
+    }
+  }
+}
+
+FFTPlanCache::~FFTPlanCache() {
+  plans.clear();
+
+  if (!new_wisdom) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> planner_lock_guard(fftw_planner_mutex());
+
+  auto path = wisdom_file_path();
+
+  std::error_code error;
+
+  std::filesystem::create_directories(path.parent_path(), error);
+
+  if (fftw_export_wisdom_to_filename(path.c_str()) == 0) {
+    util::warning("failed to save the fftw wisdom to: " + path.string());
+  }
+}
+
+auto FFTPlanCache::get(int size, bool measure) -> FFTPlan& {
+  auto it = std::find_if(plans.begin(), plans.end(), [&](const FFTPlan& p) { return p.size == size; });
+
+  if (it != plans.end()) {
+    if (measure && it->planner_flags != FFTW_MEASURE && it->n_uses > 0) {
+      plans.erase(it);
+
+      plans.emplace_front(size, FFTW_MEASURE);
+
+      new_wisdom = true;
+    } else {
+      plans.splice(plans.begin(), plans, it);  // moving it to the front
+    }
+  } else {
+    plans.emplace_front(size, FFTW_ESTIMATE);
+
+    while (plans.size() > max_plans) {
+      plans.pop_back();
+    }
+  }
+
+  auto& plan = plans.front();
+
+  plan.n_uses++;
+
+  return plan;
+}
+
+void WelchEstimator::configure(int fft_size, int hop_size, int n_segments) {
+  fft_size = std::max(fft_size, 2);
+  hop_size = std::clamp(hop_size, 1, fft_size);
+  n_segments = std::max(n_segments, 1);
+
+  if (fft_size == size && hop_size == hop && n_segments == n_averages && !periodograms.empty()) {
+    return;
+  }
+
+  size = fft_size;
+  hop = hop_size;
+  n_averages = n_segments;
+
+  const auto n_bins = (static_cast<size_t>(size) / 2U) + 1U;
+
+  periodograms.assign(static_cast<size_t>(n_averages), std::vector<double>(n_bins, 0.0));
+
+  power_sum.assign(n_bins, 0.0);
+  average.assign(n_bins, 0.0);
+
+  reset();
+}
+
+void WelchEstimator::reset() {
+  n_stored = 0;
+  ring_position = 0;
+  pending_start = 0;
+
+  pending.clear();
+
+  std::ranges::fill(power_sum, 0.0);
+  std::ranges::fill(average, 0.0);
+}
+
+auto WelchEstimator::push(std::span<const float> samples, FFTPlanCache& plans, bool measure) -> bool {
+  if (periodograms.empty()) {
+    configure(size, hop, n_averages);
+  }
+
+  pending.insert(pending.end(), samples.begin(), samples.end());
+
+  bool updated = false;
+
+  while (pending.size() - pending_start >= static_cast<size_t>(size)) {
+    add_segment(std::span<const double>(pending).subspan(pending_start, static_cast<size_t>(size)), plans, measure);
+
+    pending_start += static_cast<size_t>(hop);
+
+    updated = true;
+  }
+
+  // dropping the consumed samples only from time to time so the vector is not shifted on every buffer
+
+  if (pending_start > static_cast<size_t>(size)) {
+    pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(pending_start));
+
+    pending_start = 0;
+  }
+
+  return updated;
+}
+
+void WelchEstimator::add_segment(std::span<const double> segment, FFTPlanCache& plans, bool measure) {
+  auto& fft = plans.get(size, measure);
+
+  auto input = fft.input();
+  auto window = fft.window();
+
+  for (size_t n = 0U; n < input.size(); n++) {
+    input[n] = segment[n] * window[n];
+  }
+
+  fft.execute();
+
+  auto complex_output = fft.output();
+
+  const auto n_bins = complex_output.size();
+
+  auto& periodogram = periodograms[ring_position];
+
+  // the oldest segment leaves the running sum when its slot is reused
+
+  for (size_t i = 0U; i < n_bins; i++) {
+    double sqr = (complex_output[i][0] * complex_output[i][0]) + (complex_output[i][1] * complex_output[i][1]);
+
+    sqr /= static_cast<double>(n_bins * n_bins);
+
+    if (n_stored == periodograms.size()) {
+      power_sum[i] -= periodogram[i];
+    }
+
+    periodogram[i] = sqr;
+
+    power_sum[i] += sqr;
+  }
+
+  n_stored = std::min(n_stored + 1U, periodograms.size());
+
+  ring_position = (ring_position + 1U) % periodograms.size();
+
+  // Rebuilding the sum once per turn of the ring keeps rounding errors of the subtractions from accumulating
+
+  if (ring_position == 0U) {
+    std::ranges::fill(power_sum, 0.0);
+
+    for (const auto& p : periodograms) {
+      for (size_t i = 0U; i < n_bins; i++) {
+        power_sum[i] += p[i];
+      }
+    }
+  }
+
+  for (size_t i = 0U; i < n_bins; i++) {
+    average[i] = power_sum[i] / static_cast<double>(n_stored);
+  }
+}
+
+auto WelchEstimator::fft_size() const -> int {
+  return size;
+}
+
+auto WelchEstimator::spectrum() const -> std::span<const double> {
+  return average;
+}
+
+auto WelchEstimator::latest_periodogram() const -> std::span<const double> {
+  if (n_stored == 0U) {
+    return {};
+  }
+
+  return periodograms[(ring_position + periodograms.size() - 1U) % periodograms.size()];
+}
+
+}  // namespace sound
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <fftw3.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace sound {
+
+/*
+  Real to complex transform of a given size with its input and output buffers and the hann window. The buffers are
+  allocated by fftw so they have the alignment its simd code paths need.
+*/
+
+class FFTPlan {
+ public:
+  FFTPlan(int size, unsigned planner_flags);
+
+  FFTPlan(const FFTPlan&) = delete;
+  auto operator=(const FFTPlan&) -> FFTPlan& = delete;
+
+  ~FFTPlan();
+
+  const int size;
+
+  const unsigned planner_flags;
+
+  uint64_t n_uses = 0;
+
+  [[nodiscard]] auto input() -> std::span<double>;
+
+  [[nodiscard]] auto output() const -> std::span<const fftw_complex>;
+
+  [[nodiscard]] auto window() const -> std::span<const double>;
+
+  void execute();
+
+ private:
+  double* real_input = nullptr;
+
+  fftw_complex* complex_output = nullptr;
+
+  fftw_plan plan = nullptr;
+
+  std::vector<double> hann_window;
+};
+
+/*
+  Keeps the most recently used plans keyed by the transform size. Creating a plan costs much more than executing it
+  when the transform is small. So calc_fft should not pay for it on every audio buffer. When measured plans are
+  enabled a size is first planned with FFTW_ESTIMATE and only measured once it is requested again. This way the
+  sizes seen while the time window is still filling do not trigger expensive measurements.
+*/
+
+class FFTPlanCache {
+ public:
+  explicit FFTPlanCache(size_t max_plans = 8);
+
+  ~FFTPlanCache();
+
+  auto get(int size, bool measure) -> FFTPlan&;
+
+ private:
+  size_t max_plans;
+
+  bool new_wisdom = false;
+
+  std::list<FFTPlan> plans;  // the most recently used is at the front
+};
+
+/*
+  Welch's method: the signal is split in overlapping segments of a fixed size, each segment is windowed and
+  transformed, and the power spectrum is the average over the most recent segments. The segments are computed as soon
+  as enough new samples arrive. So the cost per audio buffer depends on the fft size and on the hop length but not on
+  how long the recording is.
+*/
+
+class WelchEstimator {
+ public:
+  void configure(int fft_size, int hop_size, int n_segments);
+
+  void reset();
+
+  // Returns true when at least one new segment entered the average
+
+  auto push(std::span<const float> samples, FFTPlanCache& plans, bool measure) -> bool;
+
+  [[nodiscard]] auto fft_size() const -> int;
+
+  [[nodiscard]] auto spectrum() const -> std::span<const double>;
+
+  // power of the segment that entered the average last
+
+  [[nodiscard]] auto latest_periodogram() const -> std::span<const double>;
+
+ private:
+  int size = 4096;
+  int hop = 2048;
+  int n_averages = 8;
+
+  size_t n_stored = 0;
+  size_t ring_position = 0;
+  size_t pending_start = 0;
+
+  std::vector<double> pending;  // samples that were not consumed by a segment yet
+
+  std::vector<std::vector<double>> periodograms;  // ring with the most recent segments
+
+  std::vector<double> power_sum;
+  std::vector<double> average;
+
+  void add_segment(std::span<const double> segment, FFTPlanCache& plans, bool measure);
+};
+
+// fftw's planner is not thread safe. Every plan creation or destruction has to hold this mutex.
+
+auto fftw_planner_mutex() -> std::mutex&;
+
+}  // namespace sound
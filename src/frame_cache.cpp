@@ -0,0 +1,131 @@
+#include "frame_cache.hpp"
+#include <qtypes.h>
+#include <QVideoFrame>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <list>
+#include <map>
+
+namespace tracker {
+
+void FrameCache::set_budget(size_t bytes) {
+  budget = bytes;
+
+  evict();
+}
+
+void FrameCache::insert(const QVideoFrame& frame) {
+  if (budget == 0U || !frame.isValid()) {
+    return;
+  }
+
+  const auto start = frame.startTime();
+
+  if (auto it = entries.find(start); it != entries.end()) {
+    touch(it);
+
+    return;
+  }
+
+  // BGRX frames have a single plane
+
+  const auto bytes = static_cast<size_t>(frame.height()) * static_cast<size_t>(frame.width()) * 4U;
+
+  recency.push_front(start);
+
+  entries.emplace(start, Entry{.frame = frame, .bytes = bytes, .lru = recency.begin()});
+
+  n_bytes += bytes;
+
+  evict();
+}
+
+auto FrameCache::find(qint64 position_us) -> QVideoFrame {
+  auto it = entries.upper_bound(position_us);
+
+  if (it == entries.begin()) {
+    return {};
+  }
+
+  it = std::prev(it);
+
+  if (position_us >= it->second.frame.endTime()) {
+    return {};
+  }
+
+  return touch(it);
+}
+
+auto FrameCache::next(qint64 start_us) -> QVideoFrame {
+  auto current = entries.find(start_us);
+
+  if (current == entries.end()) {
+    return {};
+  }
+
+  auto it = std::next(current);
+
+  // only a frame that starts where the current one ends is known to be the next one
+
+  if (it == entries.end() || !adjacent(current->second.frame, it->second.frame)) {
+    return {};
+  }
+
+  return touch(it);
+}
+
+auto FrameCache::previous(qint64 start_us) -> QVideoFrame {
+  auto current = entries.find(start_us);
+
+  if (current == entries.end() || current == entries.begin()) {
+    return {};
+  }
+
+  auto it = std::prev(current);
+
+  if (!adjacent(it->second.frame, current->second.frame)) {
+    return {};
+  }
+
+  return touch(it);
+}
+
+void FrameCache::clear() {
+  entries.clear();
+  recency.clear();
+
+  n_bytes = 0;
+}
+
+auto FrameCache::size_bytes() const -> size_t {
+  return n_bytes;
+}
+
+auto FrameCache::adjacent(const QVideoFrame& first, const QVideoFrame& second) -> bool {
+  // the timestamps were rounded to microseconds. Half a frame of tolerance absorbs that
+
+  const auto half_duration = (first.endTime() - first.startTime()) / 2;
+
+  return std::abs(second.startTime() - first.endTime()) <= half_duration;
+}
+
+auto FrameCache::touch(std::map<qint64, Entry>::iterator it) -> QVideoFrame {
+  recency.splice(recency.begin(), recency, it->second.lru);
+
+  return it->second.frame;
+}
+
+void FrameCache::evict() {
+  while (n_bytes > budget && !recency.empty()) {
+    auto it = entries.find(recency.back());
+
+    n_bytes -= it->second.bytes;
+
+    entries.erase(it);
+
+    recency.pop_back();
+  }
+}
+
+}  // namespace tracker
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <qtypes.h>
+#include <QVideoFrame>
+#include <cstddef>
+#include <list>
+#include <map>
+
+namespace tracker {
+
+/*
+  Least recently used cache of decoded frames that were already scaled to the preview size. The frames are indexed by
+  their start time so that a seek can find the frame covering any position. The total size of the stored frames is
+  kept below a budget in bytes. A budget of 0 disables the cache.
+*/
+
+class FrameCache {
+ public:
+  void set_budget(size_t bytes);
+
+  void insert(const QVideoFrame& frame);
+
+  // frame whose display interval contains position_us. Invalid when it is not cached
+
+  auto find(qint64 position_us) -> QVideoFrame;
+
+  // frames adjacent to the one starting at start_us. Invalid when they are not cached
+
+  auto next(qint64 start_us) -> QVideoFrame;
+
+  auto previous(qint64 start_us) -> QVideoFrame;
+
+  void clear();
+
+  [[nodiscard]] auto size_bytes() const -> size_t;
+
+ private:
+  struct Entry {
+    QVideoFrame frame;
+
+    size_t bytes = 0;
+
+    std::list<qint64>::iterator lru;  // position in the recency list
+  };
+
+  size_t budget = 0;
+  size_t n_bytes = 0;
+
+  std::map<qint64, Entry> entries;  // by start time
+
+  std::list<qint64> recency;  // most recently used first
+
+  auto touch(std::map<qint64, Entry>::iterator it) -> QVideoFrame;
+
+  void evict();
+
+  static auto adjacent(const QVideoFrame& first, const QVideoFrame& second) -> bool;
+};
+
+}  // namespace tracker
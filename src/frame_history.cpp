@@ -0,0 +1,113 @@
+#include "frame_history.hpp"
+#include <qtypes.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <utility>
+
+namespace tracker {
+
+void FrameHistory::set_capacity(size_t n_frames) {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  capacity = n_frames;
+
+  while (frames.size() > capacity) {
+    frames.pop_front();
+
+    n_first++;
+  }
+}
+
+void FrameHistory::push(qint64 time_us, const cv::Mat& image, cv::Point2d scale) {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  if (capacity == 0U) {
+    return;
+  }
+
+  if (!frames.empty()) {
+    if (time_us == frames.back().time_us) {
+      return;  // the paused preview being redrawn
+    }
+
+    const auto& last = frames.back();
+
+    if (time_us < last.time_us || image.size() != last.image.size() || image.type() != last.image.type() ||
+        scale != last.scale) {
+      n_first += frames.size();
+
+      frames.clear();
+    }
+  }
+
+  Frame frame;
+
+  if (frames.size() == capacity) {
+    frame = std::move(frames.front());
+
+    frames.pop_front();
+
+    n_first++;
+  }
+
+  frame.time_us = time_us;
+  frame.scale = scale;
+
+  image.copyTo(frame.image);  // only allocates when the recycled buffer does not fit
+
+  frames.push_back(std::move(frame));
+}
+
+auto FrameHistory::copy(uint64_t sequence, cv::Mat& image, qint64& time_us, cv::Point2d& scale) -> bool {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  if (sequence < n_first || sequence >= n_first + frames.size()) {
+    return false;
+  }
+
+  const auto& frame = frames[sequence - n_first];
+
+  frame.image.copyTo(image);
+
+  time_us = frame.time_us;
+  scale = frame.scale;
+
+  return true;
+}
+
+auto FrameHistory::first_sequence() -> uint64_t {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  return n_first;
+}
+
+auto FrameHistory::end_sequence() -> uint64_t {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  return n_first + frames.size();
+}
+
+auto FrameHistory::empty() -> bool {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  return frames.empty();
+}
+
+auto FrameHistory::enabled() -> bool {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  return capacity > 0U;
+}
+
+void FrameHistory::clear() {
+  std::lock_guard<std::mutex> frames_lock_guard(frames_mutex);
+
+  n_first += frames.size();
+
+  frames.clear();
+}
+
+}  // namespace tracker
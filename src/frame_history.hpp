@@ -0,0 +1,61 @@
+#pragma once
+
+#include <qtypes.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+namespace tracker {
+
+/*
+  Bounded buffer with the most recent frames given to the trackers. The frames are kept reduced to fit in the
+  preview, each with its scale in history pixels per analysis pixel. Every image gets a sequence number that keeps
+  growing, so a reader can walk the buffer while new images are pushed and old ones are evicted. The images are copied
+  in and out under the lock and the buffers of evicted images are reused for the new ones.
+*/
+
+class FrameHistory {
+ public:
+  void set_capacity(size_t n_frames);
+
+  // Images older than the last one or with a different size, type or scale start a new history. It happens after
+  // seeks and when the preview size, the tracking resolution or the algorithm change.
+
+  void push(qint64 time_us, const cv::Mat& image, cv::Point2d scale);
+
+  // false when the image was already evicted or was not pushed yet
+
+  auto copy(uint64_t sequence, cv::Mat& image, qint64& time_us, cv::Point2d& scale) -> bool;
+
+  [[nodiscard]] auto enabled() -> bool;  // false when nothing is kept
+
+  [[nodiscard]] auto first_sequence() -> uint64_t;
+
+  [[nodiscard]] auto end_sequence() -> uint64_t;  // one past the newest image
+
+  [[nodiscard]] auto empty() -> bool;
+
+  void clear();
+
+ private:
+  struct Frame {
+    qint64 time_us = 0;
+
+    cv::Mat image;  // CV_8UC3 or CV_8UC1
+
+    cv::Point2d scale;
+  };
+
+  size_t capacity = 0;
+
+  uint64_t n_first = 0;  // sequence number of frames.front()
+
+  std::deque<Frame> frames;
+
+  std::mutex frames_mutex;
+};
+
+}  // namespace tracker
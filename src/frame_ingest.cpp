@@ -0,0 +1,461 @@
+#include "frame_ingest.hpp"
+#include <qimage.h>
+#include <qvideoframe.h>
+#include <qvideoframeformat.h>
+#include <QVideoFrame>
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/interface.h>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <string>
+#include "util.hpp"
+
+namespace tracker {
+
+auto FrameIngest::convert(const QVideoFrame& input_frame,
+                          const cv::Size& size,
+                          int interpolation,
+                          const TrackingWindows& tracking) -> bool {
+  if (!input_frame.isValid()) {
+    return false;
+  }
+
+  const bool need_windows = !tracking.windows.empty() && (tracking.need_bgr || tracking.need_gray);
+
+  native.release();
+
+  // Mapping needs a non const frame. The copy only shares the underlying buffer.
+
+  QVideoFrame frame = input_frame;
+
+  if (!frame.map(QVideoFrame::ReadOnly)) {
+    util::warning("Failed to map the QVideoFrame. Using the QImage conversion.");
+
+    from_qimage(input_frame, size, interpolation);
+
+    if (need_windows && !native.empty()) {
+      convert_windows(frame, tracking);
+    }
+
+    return !bgr.empty();
+  }
+
+  bool mapped = true;
+
+  try {
+    switch (frame.pixelFormat()) {
+      case QVideoFrameFormat::Format_NV12: {
+        from_nv12(frame, size, interpolation, false);
+        break;
+      }
+      case QVideoFrameFormat::Format_NV21: {
+        from_nv12(frame, size, interpolation, true);
+        break;
+      }
+      case QVideoFrameFormat::Format_YUV420P: {
+        from_yuv420p(frame, size, interpolation, false);
+        break;
+      }
+      case QVideoFrameFormat::Format_YV12: {
+        from_yuv420p(frame, size, interpolation, true);
+        break;
+      }
+      case QVideoFrameFormat::Format_YUYV: {
+        from_packed_yuv(frame, size, interpolation, false);
+        break;
+      }
+      case QVideoFrameFormat::Format_UYVY: {
+        from_packed_yuv(frame, size, interpolation, true);
+        break;
+      }
+      case QVideoFrameFormat::Format_BGRA8888:
+      case QVideoFrameFormat::Format_BGRX8888: {
+        from_rgb32(frame, size, interpolation, false);
+        break;
+      }
+      case QVideoFrameFormat::Format_RGBA8888:
+      case QVideoFrameFormat::Format_RGBX8888: {
+        from_rgb32(frame, size, interpolation, true);
+        break;
+      }
+      case QVideoFrameFormat::Format_Jpeg: {
+        mapped = from_jpeg(frame, size, interpolation, need_windows);
+        break;
+      }
+      default: {
+        mapped = false;
+        break;
+      }
+    }
+
+    // the windows are cropped from the mapped planes, so this has to happen before unmapping
+
+    if (mapped && need_windows) {
+      convert_windows(frame, tracking);
+    }
+  } catch (const cv::Exception& e) {
+    util::warning(std::string("OpenCV failed to convert the mapped frame: ") + e.what());
+
+    mapped = false;
+  }
+
+  frame.unmap();
+
+  if (!mapped) {
+    native.release();
+
+    from_qimage(input_frame, size, interpolation);
+
+    if (need_windows && !native.empty()) {
+      convert_windows(frame, tracking);
+    }
+  }
+
+  return !bgr.empty();
+}
+
+void FrameIngest::scale_to(const cv::Mat& src, cv::Mat& dst, const cv::Size& size, int interpolation) {
+  // cv::resize and copyTo only reallocate dst when its size or type changes
+
+  if (src.size() == size) {
+    src.copyTo(dst);
+  } else {
+    cv::resize(src, dst, size, 0, 0, interpolation);
+  }
+}
+
+void FrameIngest::from_nv12(QVideoFrame& frame, const cv::Size& size, int interpolation, bool nv21) {
+  const cv::Mat y_plane(frame.height(), frame.width(), CV_8UC1, frame.bits(0), frame.bytesPerLine(0));
+  const cv::Mat uv_plane(frame.height() / 2, frame.width() / 2, CV_8UC2, frame.bits(1), frame.bytesPerLine(1));
+
+  const auto code = nv21 ? cv::COLOR_YUV2BGR_NV21 : cv::COLOR_YUV2BGR_NV12;
+
+  // The 4:2:0 conversion needs even dimensions. Odd sizes are handled by a last scaling step.
+
+  const cv::Size even(size.width & ~1, size.height & ~1);
+
+  // Scaling the planes before the color conversion means the conversion only runs on the output pixels
+
+  scale_to(y_plane, luma, even, interpolation);
+  scale_to(uv_plane, chroma, even / 2, interpolation);
+
+  if (even == size) {
+    cv::cvtColorTwoPlane(luma, chroma, bgr, code);
+  } else {
+    cv::cvtColorTwoPlane(luma, chroma, full, code);
+
+    scale_to(full, bgr, size, interpolation);
+  }
+}
+
+void FrameIngest::from_yuv420p(QVideoFrame& frame, const cv::Size& size, int interpolation, bool yv12) {
+  const cv::Mat y_plane(frame.height(), frame.width(), CV_8UC1, frame.bits(0), frame.bytesPerLine(0));
+  const cv::Mat c1_plane(frame.height() / 2, frame.width() / 2, CV_8UC1, frame.bits(1), frame.bytesPerLine(1));
+  const cv::Mat c2_plane(frame.height() / 2, frame.width() / 2, CV_8UC1, frame.bits(2), frame.bytesPerLine(2));
+
+  const cv::Size even(size.width & ~1, size.height & ~1);
+  const cv::Size even_chroma = even / 2;
+
+  // OpenCV expects the three planes one after the other in a single buffer. The scaled planes are written directly
+  // into their place inside it.
+
+  i420.create((even.height * 3) / 2, even.width, CV_8UC1);
+
+  cv::Mat y_dst = i420.rowRange(0, even.height);
+  cv::Mat c1_dst(even_chroma, CV_8UC1, i420.ptr(even.height));
+  cv::Mat c2_dst(even_chroma, CV_8UC1, i420.ptr(even.height) + even_chroma.area());
+
+  scale_to(y_plane, y_dst, even, interpolation);
+  scale_to(c1_plane, c1_dst, even_chroma, interpolation);
+  scale_to(c2_plane, c2_dst, even_chroma, interpolation);
+
+  const auto code = yv12 ? cv::COLOR_YUV2BGR_YV12 : cv::COLOR_YUV2BGR_I420;
+
+  if (even == size) {
+    cv::cvtColor(i420, bgr, code);
+  } else {
+    cv::cvtColor(i420, full, code);
+
+    scale_to(full, bgr, size, interpolation);
+  }
+}
+
+void FrameIngest::from_packed_yuv(QVideoFrame& frame, const cv::Size& size, int interpolation, bool uyvy) {
+  const cv::Mat packed(frame.height(), frame.width(), CV_8UC2, frame.bits(0), frame.bytesPerLine(0));
+
+  // Interpolating the packed pixels would mix U and V samples. So the color conversion has to come first.
+
+  if (packed.size() == size) {
+    cv::cvtColor(packed, bgr, uyvy ? cv::COLOR_YUV2BGR_UYVY : cv::COLOR_YUV2BGR_YUYV);
+  } else {
+    cv::cvtColor(packed, full, uyvy ? cv::COLOR_YUV2BGR_UYVY : cv::COLOR_YUV2BGR_YUYV);
+
+    scale_to(full, bgr, size, interpolation);
+  }
+}
+
+void FrameIngest::from_rgb32(QVideoFrame& frame, const cv::Size& size, int interpolation, bool rgba) {
+  const cv::Mat rgb32(frame.height(), frame.width(), CV_8UC4, frame.bits(0), frame.bytesPerLine(0));
+
+  if (rgb32.size() != size) {
+    cv::resize(rgb32, full, size, 0, 0, interpolation);
+  }
+
+  const cv::Mat& scaled = (rgb32.size() == size) ? rgb32 : full;
+
+  cv::cvtColor(scaled, bgr, rgba ? cv::COLOR_RGBA2BGR : cv::COLOR_BGRA2BGR);
+}
+
+auto FrameIngest::from_jpeg(QVideoFrame& frame, const cv::Size& size, int interpolation, bool need_native) -> bool {
+  const cv::Mat encoded(1, static_cast<int>(frame.mappedBytes(0)), CV_8UC1, frame.bits(0));
+
+  // A jpeg cannot be cropped before decoding. When the trackers need the native resolution the preview is scaled
+  // from the same decoded image.
+
+  if (need_native) {
+    cv::imdecode(encoded, cv::IMREAD_COLOR, &decoded);
+
+    if (decoded.empty()) {
+      return false;
+    }
+
+    native = decoded;
+
+    scale_to(native, bgr, size, interpolation);
+
+    return true;
+  }
+
+  // libjpeg can decode directly at 1/2, 1/4 or 1/8 of the resolution. It is the cheapest downscaling available.
+
+  int flags = cv::IMREAD_COLOR;
+
+  if (frame.width() >= 8 * size.width && frame.height() >= 8 * size.height) {
+    flags = cv::IMREAD_REDUCED_COLOR_8;
+  } else if (frame.width() >= 4 * size.width && frame.height() >= 4 * size.height) {
+    flags = cv::IMREAD_REDUCED_COLOR_4;
+  } else if (frame.width() >= 2 * size.width && frame.height() >= 2 * size.height) {
+    flags = cv::IMREAD_REDUCED_COLOR_2;
+  }
+
+  cv::imdecode(encoded, flags, &full);
+
+  if (full.empty()) {
+    return false;
+  }
+
+  scale_to(full, bgr, size, interpolation);
+
+  return true;
+}
+
+void FrameIngest::from_qimage(const QVideoFrame& frame, const cv::Size& size, int interpolation) {
+  fallback_image = frame.toImage().convertedTo(QImage::Format_BGR888);
+
+  if (fallback_image.isNull()) {
+    bgr.release();
+
+    return;
+  }
+
+  native = cv::Mat(fallback_image.height(), fallback_image.width(), CV_8UC3, fallback_image.bits(),
+                   fallback_image.bytesPerLine());
+
+  scale_to(native, bgr, size, interpolation);
+}
+
+void FrameIngest::convert_windows(QVideoFrame& frame, const TrackingWindows& tracking) {
+  // The pixels outside the windows are never written. Clearing new buffers keeps them deterministic.
+
+  if (tracking.need_bgr && (tracking_bgr.size() != tracking.size || tracking_bgr.type() != CV_8UC3)) {
+    tracking_bgr = cv::Mat::zeros(tracking.size, CV_8UC3);
+  }
+
+  if (tracking.need_gray && (tracking_gray.size() != tracking.size || tracking_gray.type() != CV_8UC1)) {
+    tracking_gray = cv::Mat::zeros(tracking.size, CV_8UC1);
+  }
+
+  const cv::Size frame_size = native.empty() ? cv::Size(frame.width(), frame.height()) : native.size();
+
+  // native pixels per tracking pixel
+
+  const cv::Point2d scale(static_cast<double>(frame_size.width) / tracking.size.width,
+                          static_cast<double>(frame_size.height) / tracking.size.height);
+
+  // The chroma subsampling of the yuv formats needs crops starting and ending on even coordinates
+
+  const cv::Rect even_frame(0, 0, frame_size.width & ~1, frame_size.height & ~1);
+
+  for (const auto& window : tracking.windows) {
+    const int x0 = cvFloor(window.x * scale.x) & ~1;
+    const int y0 = cvFloor(window.y * scale.y) & ~1;
+    const int x1 = (cvCeil((window.x + window.width) * scale.x) + 1) & ~1;
+    const int y1 = (cvCeil((window.y + window.height) * scale.y) + 1) & ~1;
+
+    const cv::Rect source = cv::Rect(cv::Point(x0, y0), cv::Point(x1, y1)) & even_frame;
+
+    if (source.empty()) {
+      continue;
+    }
+
+    // either views of the frame or the crop buffers
+
+    cv::Mat window_bgr;
+    cv::Mat window_gray;
+
+    crop(frame, source, tracking.need_bgr, tracking.need_gray, window_bgr, window_gray);
+
+    if (tracking.need_bgr) {
+      place(window_bgr, source, window, scale, tracking_bgr);
+    }
+
+    if (tracking.need_gray) {
+      place(window_gray, source, window, scale, tracking_gray);
+    }
+  }
+}
+
+void FrameIngest::crop(QVideoFrame& frame,
+                       const cv::Rect& source,
+                       bool need_bgr,
+                       bool need_gray,
+                       cv::Mat& window_bgr,
+                       cv::Mat& window_gray) {
+  // The crop buffers are only written by the conversions. The views of the frame are handed out through the output
+  // parameters, so that a later conversion never writes into an unmapped plane.
+
+  if (!native.empty()) {
+    window_bgr = native(source);
+
+    if (need_gray) {
+      cv::cvtColor(window_bgr, crop_gray, cv::COLOR_BGR2GRAY);
+
+      window_gray = crop_gray;
+    }
+
+    return;
+  }
+
+  // Only views of the mapped planes are created here. Nothing outside the source rectangle is read.
+
+  const cv::Rect chroma_source(source.x / 2, source.y / 2, source.width / 2, source.height / 2);
+
+  switch (frame.pixelFormat()) {
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21: {
+      const cv::Mat y_plane(frame.height(), frame.width(), CV_8UC1, frame.bits(0), frame.bytesPerLine(0));
+      const cv::Mat uv_plane(frame.height() / 2, frame.width() / 2, CV_8UC2, frame.bits(1), frame.bytesPerLine(1));
+
+      if (need_bgr) {
+        const bool nv21 = frame.pixelFormat() == QVideoFrameFormat::Format_NV21;
+
+        cv::cvtColorTwoPlane(y_plane(source), uv_plane(chroma_source), crop_bgr,
+                             nv21 ? cv::COLOR_YUV2BGR_NV21 : cv::COLOR_YUV2BGR_NV12);
+      }
+
+      window_gray = y_plane(source);
+
+      break;
+    }
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YV12: {
+      const cv::Mat y_plane(frame.height(), frame.width(), CV_8UC1, frame.bits(0), frame.bytesPerLine(0));
+      const cv::Mat c1_plane(frame.height() / 2, frame.width() / 2, CV_8UC1, frame.bits(1), frame.bytesPerLine(1));
+      const cv::Mat c2_plane(frame.height() / 2, frame.width() / 2, CV_8UC1, frame.bits(2), frame.bytesPerLine(2));
+
+      if (need_bgr) {
+        const cv::Size chroma_size = chroma_source.size();
+
+        i420.create((source.height * 3) / 2, source.width, CV_8UC1);
+
+        cv::Mat y_dst = i420.rowRange(0, source.height);
+        cv::Mat c1_dst(chroma_size, CV_8UC1, i420.ptr(source.height));
+        cv::Mat c2_dst(chroma_size, CV_8UC1, i420.ptr(source.height) + chroma_size.area());
+
+        y_plane(source).copyTo(y_dst);
+        c1_plane(chroma_source).copyTo(c1_dst);
+        c2_plane(chroma_source).copyTo(c2_dst);
+
+        const bool yv12 = frame.pixelFormat() == QVideoFrameFormat::Format_YV12;
+
+        cv::cvtColor(i420, crop_bgr, yv12 ? cv::COLOR_YUV2BGR_YV12 : cv::COLOR_YUV2BGR_I420);
+      }
+
+      window_gray = y_plane(source);
+
+      break;
+    }
+    case QVideoFrameFormat::Format_YUYV:
+    case QVideoFrameFormat::Format_UYVY: {
+      const cv::Mat packed(frame.height(), frame.width(), CV_8UC2, frame.bits(0), frame.bytesPerLine(0));
+
+      const bool uyvy = frame.pixelFormat() == QVideoFrameFormat::Format_UYVY;
+
+      if (need_bgr) {
+        cv::cvtColor(packed(source), crop_bgr, uyvy ? cv::COLOR_YUV2BGR_UYVY : cv::COLOR_YUV2BGR_YUYV);
+      }
+
+      if (need_gray) {
+        cv::extractChannel(packed(source), crop_gray, uyvy ? 1 : 0);
+      }
+
+      break;
+    }
+    default: {
+      const cv::Mat rgb32(frame.height(), frame.width(), CV_8UC4, frame.bits(0), frame.bytesPerLine(0));
+
+      const bool rgba = frame.pixelFormat() == QVideoFrameFormat::Format_RGBA8888 ||
+                        frame.pixelFormat() == QVideoFrameFormat::Format_RGBX8888;
+
+      if (need_bgr) {
+        cv::cvtColor(rgb32(source), crop_bgr, rgba ? cv::COLOR_RGBA2BGR : cv::COLOR_BGRA2BGR);
+      }
+
+      if (need_gray) {
+        cv::cvtColor(rgb32(source), crop_gray, rgba ? cv::COLOR_RGBA2GRAY : cv::COLOR_BGRA2GRAY);
+      }
+
+      break;
+    }
+  }
+
+  if (need_bgr) {
+    window_bgr = crop_bgr;
+  }
+
+  if (need_gray && window_gray.empty()) {
+    window_gray = crop_gray;
+  }
+}
+
+void FrameIngest::place(const cv::Mat& image,
+                        const cv::Rect& source,
+                        const cv::Rect& window,
+                        cv::Point2d scale,
+                        cv::Mat& dst) {
+  // dst(window) is a view, so the OpenCV functions below write in place instead of reallocating
+
+  if (scale.x == 1.0 && scale.y == 1.0) {
+    const auto inside = window & source;
+
+    image(inside - source.tl()).copyTo(dst(inside));
+
+    return;
+  }
+
+  // The crop is resampled with the exact mapping of the whole frame. So the pixels of different windows, or of the
+  // same window in different frames, line up. Pixel centers are at half integers in both images.
+
+  cv::Mat target = dst(window);
+
+  const cv::Matx23d tracking_to_crop(scale.x, 0.0, ((window.x + 0.5) * scale.x) - 0.5 - source.x,  //
+                                     0.0, scale.y, ((window.y + 0.5) * scale.y) - 0.5 - source.y);
+
+  cv::warpAffine(image, target, tracking_to_crop, window.size(), cv::INTER_LINEAR | cv::WARP_INVERSE_MAP,
+                 cv::BORDER_REPLICATE);
+}
+
+}  // namespace tracker
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QImage>
+#include <QVideoFrame>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <vector>
+
+namespace tracker {
+
+// Parts of the frame the trackers will read. The windows are given in the pixels of the tracking images.
+
+struct TrackingWindows {
+  cv::Size size;  // of the tracking images
+
+  std::vector<cv::Rect> windows;
+
+  bool need_bgr = false;
+  bool need_gray = false;
+};
+
+/*
+  Converts camera and media player frames to the OpenCV images used by the preview and the trackers. Whenever the
+  pixel format allows the frame planes are mapped and read in place. The scaling and color conversion write straight
+  into buffers that are reused between frames.
+
+  The preview image is always converted entirely, but from planes scaled down first. The tracking images are only
+  converted inside the search windows of the trackers, starting from the native resolution crops. So their cost
+  follows the area of the ROIs instead of the resolution of the camera.
+*/
+
+class FrameIngest {
+ public:
+  auto convert(const QVideoFrame& frame, const cv::Size& size, int interpolation, const TrackingWindows& tracking)
+      -> bool;
+
+  cv::Mat bgr;  // CV_8UC3 preview with the requested size
+
+  // CV_8UC3 and CV_8UC1 images with the size of the tracking request. Only the pixels inside the windows are updated.
+  // The others keep the contents of previous frames.
+
+  cv::Mat tracking_bgr;
+  cv::Mat tracking_gray;
+
+ private:
+  cv::Mat full;     // intermediate image at the native resolution
+  cv::Mat luma;     // scaled Y plane
+  cv::Mat chroma;   // scaled interleaved uv plane
+  cv::Mat i420;     // planar yuv 4:2:0 image in a single continuous buffer
+  cv::Mat decoded;  // jpeg frame decoded at the native resolution
+
+  cv::Mat native;  // whole frame as BGR for the formats that cannot be cropped in place. Empty otherwise
+
+  cv::Mat crop_bgr;   // search window converted at the native resolution
+  cv::Mat crop_gray;  // search window luma at the native resolution, when it is not a plane of the frame
+
+  QImage fallback_image;
+
+  void from_nv12(QVideoFrame& frame, const cv::Size& size, int interpolation, bool nv21);
+  void from_yuv420p(QVideoFrame& frame, const cv::Size& size, int interpolation, bool yv12);
+  void from_packed_yuv(QVideoFrame& frame, const cv::Size& size, int interpolation, bool uyvy);
+  void from_rgb32(QVideoFrame& frame, const cv::Size& size, int interpolation, bool rgba);
+  auto from_jpeg(QVideoFrame& frame, const cv::Size& size, int interpolation, bool need_native) -> bool;
+  void from_qimage(const QVideoFrame& frame, const cv::Size& size, int interpolation);
+
+  void convert_windows(QVideoFrame& frame, const TrackingWindows& tracking);
+  void crop(QVideoFrame& frame,
+            const cv::Rect& source,
+            bool need_bgr,
+            bool need_gray,
+            cv::Mat& window_bgr,
+            cv::Mat& window_gray);
+
+  static void scale_to(const cv::Mat& src, cv::Mat& dst, const cv::Size& size, int interpolation);
+  static void place(const cv::Mat& image,
+                    const cv::Rect& source,
+                    const cv::Rect& window,
+                    cv::Point2d scale,
+                    cv::Mat& dst);
+};
+
+}  // namespace tracker
@@ -0,0 +1,94 @@
+#include "frame_pipeline.hpp"
+#include <qtypes.h>
+#include <QVideoFrame>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace tracker {
+
+FramePipeline::FramePipeline(std::function<void(const QVideoFrame&)> callback, size_t capacity)
+    : capacity(std::max(capacity, static_cast<size_t>(1))), callback(std::move(callback)) {
+  worker = std::thread([this]() { work(); });
+}
+
+FramePipeline::~FramePipeline() {
+  stop();
+}
+
+void FramePipeline::push(const QVideoFrame& frame) {
+  {
+    std::lock_guard<std::mutex> queue_lock_guard(queue_mutex);
+
+    if (!running) {
+      return;
+    }
+
+    while (queue.size() >= capacity) {
+      queue.pop_front();
+
+      n_dropped++;
+    }
+
+    queue.push_back(frame);
+
+    depth = static_cast<int>(queue.size());
+  }
+
+  queue_cv.notify_one();
+}
+
+void FramePipeline::stop() {
+  {
+    std::lock_guard<std::mutex> queue_lock_guard(queue_mutex);
+
+    running = false;
+
+    queue.clear();
+
+    depth = 0;
+  }
+
+  queue_cv.notify_one();
+
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+auto FramePipeline::dropped_frames() const -> qint64 {
+  return n_dropped;
+}
+
+auto FramePipeline::queue_depth() const -> int {
+  return depth;
+}
+
+void FramePipeline::work() {
+  while (true) {
+    QVideoFrame frame;
+
+    {
+      std::unique_lock<std::mutex> queue_lock(queue_mutex);
+
+      queue_cv.wait(queue_lock, [this]() { return !running || !queue.empty(); });
+
+      if (!running) {
+        return;
+      }
+
+      frame = queue.front();
+
+      queue.pop_front();
+
+      depth = static_cast<int>(queue.size());
+    }
+
+    callback(frame);
+  }
+}
+
+}  // namespace tracker
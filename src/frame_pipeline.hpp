@@ -0,0 +1,55 @@
+#pragma once
+
+#include <qtypes.h>
+#include <QVideoFrame>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace tracker {
+
+/*
+  Bounded queue between the thread delivering video frames and a worker thread that runs the tracking. When the
+  worker falls behind the oldest queued frame is discarded so that the latest frame always wins.
+*/
+
+class FramePipeline {
+ public:
+  FramePipeline(std::function<void(const QVideoFrame&)> callback, size_t capacity = 1);
+
+  ~FramePipeline();
+
+  void push(const QVideoFrame& frame);
+
+  void stop();
+
+  [[nodiscard]] auto dropped_frames() const -> qint64;
+
+  [[nodiscard]] auto queue_depth() const -> int;
+
+ private:
+  bool running = true;
+
+  size_t capacity;
+
+  std::atomic<qint64> n_dropped = 0;
+  std::atomic<int> depth = 0;
+
+  std::deque<QVideoFrame> queue;
+
+  std::function<void(const QVideoFrame&)> callback;
+
+  std::mutex queue_mutex;
+
+  std::condition_variable queue_cv;
+
+  std::thread worker;
+
+  void work();
+};
+
+}  // namespace tracker
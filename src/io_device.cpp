@@ -4,7 +4,6 @@
 #include <qtmetamacros.h>
 #include <qtpreprocessorsupport.h>
 #include <qtypes.h>
-#include <algorithm>
 #include <bit>
 #include <cstddef>
 #include <span>
@@ -24,17 +23,16 @@ qint64 IODevice::readData(char* data, qint64 maxSize) {
 }
 
 qint64 IODevice::writeData(const char* data, qint64 maxSize) {
-  const int n_samples = maxSize / format.bytesPerSample();
+  // This runs in the audio callback. No allocation, no conversion and no lock. Just a copy into the ring.
 
-  if (buffer.size() != static_cast<size_t>(n_samples)) {
-    buffer.resize(n_samples);
-  }
+  const auto n_samples = static_cast<size_t>(maxSize / format.bytesPerSample());
 
   auto input_data = std::span<const float>(std::bit_cast<const float*>(data), n_samples);
 
-  std::copy(input_data.begin(), input_data.end(), buffer.begin());
-
-  Q_EMIT bufferChanged(buffer);
+  if (const auto n_written = ring.write(input_data); n_written < n_samples) {
+    overrun_samples.fetch_add(static_cast<qint64>(n_samples - n_written), std::memory_order_relaxed);
+    overrun_events.fetch_add(1, std::memory_order_relaxed);
+  }
 
   return maxSize;
 }
@@ -7,7 +7,8 @@
 #include <QIODevice>
 #include <QList>
 #include <QPointF>
-#include <vector>
+#include <atomic>
+#include "spsc_ring.hpp"
 
 namespace sound {
 
@@ -20,8 +21,13 @@ class IODevice : public QIODevice {
 
   static const int sampleCount = 2000;
 
- signals:
-  void bufferChanged(std::vector<double> value);
+  // About 2.7 seconds at 48 kHz. The analysis thread is the only reader
+
+  util::SpscRing<float> ring{131072};
+
+  std::atomic<qint64> overrun_samples = 0;  // samples dropped because the ring was full
+
+  std::atomic<qint64> overrun_events = 0;  // writeData calls that had to drop samples
 
  protected:
   qint64 readData(char* data, qint64 maxSize) override;
@@ -31,8 +37,6 @@ class IODevice : public QIODevice {
   QAudioFormat format;
 
   QList<QPointF> m_buffer;
-
-  std::vector<double> buffer;
 };
 
 }  // namespace sound
\ No newline at end of file
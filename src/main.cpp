@@ -14,6 +14,7 @@
 #include <QApplication>
 #include <QtQml>
 #include <memory>
+#include "batch.hpp"
 #include "config.h"
 #include "eyeofsauron_db.h"
 #include "sound_wave.hpp"
@@ -72,6 +73,17 @@ void construct_about_window() {
 }
 
 int main(int argc, char* argv[]) {
+  if (batch::requested(argc, argv)) {
+    QCoreApplication app(argc, argv);
+
+    KLocalizedString::setApplicationDomain(APPLICATION_DOMAIN);
+    QCoreApplication::setOrganizationName(QStringLiteral(ORGANIZATION_NAME));
+    QCoreApplication::setOrganizationDomain(QStringLiteral(ORGANIZATION_DOMAIN));
+    QCoreApplication::setApplicationName(QStringLiteral("eyeofsauron"));
+
+    return batch::run(app);
+  }
+
   auto lockFile = get_lock_file();
 
   if (!lockFile->isLocked()) {
@@ -0,0 +1,174 @@
+#include "marker_engine.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/imgproc.hpp>
+#include "tracker_engine.hpp"
+#include "util.hpp"
+
+namespace tracker {
+
+constexpr int hue_range = 180;  // OpenCV stores the hue divided by 2 in 8 bit images
+
+constexpr int min_marker_area = 3;  // smaller components are considered noise
+
+MarkerEngine::MarkerEngine(int algorithm, MarkerOptions options) : TrackerEngine(algorithm), options(options) {}
+
+void MarkerEngine::do_init(const cv::Mat& image, const cv::Rect2d& roi) {
+  const auto window = cv::Rect(roi) & cv::Rect(0, 0, image.cols, image.rows);
+
+  hue = -1;
+
+  if (window.empty()) {
+    return;
+  }
+
+  cv::cvtColor(image(window), hsv, cv::COLOR_BGR2HSV);
+
+  // the marker hue is the most common one among the pixels that are colored and bright enough
+
+  std::array<int, hue_range> histogram{};
+
+  for (int y = 0; y < hsv.rows; y++) {
+    const auto* p = hsv.ptr<uchar>(y);
+
+    for (int x = 0; x < hsv.cols; x++, p += 3) {
+      if (p[1] >= options.min_saturation && p[2] >= options.min_value) {
+        histogram[p[0] % hue_range]++;
+      }
+    }
+  }
+
+  const auto* peak = std::ranges::max_element(histogram);
+
+  if (*peak == 0) {
+    util::warning("The roi does not contain a colored marker. Try lowering the minimum saturation or value");
+
+    return;
+  }
+
+  hue = static_cast<int>(peak - histogram.begin());
+}
+
+auto MarkerEngine::do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool {
+  if (hue < 0) {
+    return false;
+  }
+
+  // the search window is three times the roi around its previous position
+
+  const auto search = cv::Rect(cv::Rect2d(roi.x - roi.width, roi.y - roi.height, 3.0 * roi.width, 3.0 * roi.height)) &
+                      cv::Rect(0, 0, image.cols, image.rows);
+
+  if (search.empty()) {
+    return false;
+  }
+
+  cv::cvtColor(image(search), hsv, cv::COLOR_BGR2HSV);
+
+  threshold();
+
+  const int n_labels = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+
+  // label 0 is the background
+
+  const double previous_x = roi.x + (roi.width * 0.5) - search.x;
+  const double previous_y = roi.y + (roi.height * 0.5) - search.y;
+
+  int best = 0;
+
+  double best_distance = std::numeric_limits<double>::max();
+
+  for (int n = 1; n < n_labels; n++) {
+    if (stats.at<int>(n, cv::CC_STAT_AREA) < min_marker_area) {
+      continue;
+    }
+
+    const double dx = centroids.at<double>(n, 0) - previous_x;
+    const double dy = centroids.at<double>(n, 1) - previous_y;
+
+    if (const double distance = (dx * dx) + (dy * dy); distance < best_distance) {
+      best = n;
+      best_distance = distance;
+    }
+  }
+
+  if (best == 0) {
+    return false;
+  }
+
+  // Centroid weighted by the saturation, only over the bounding box of the component. The border pixels are partly
+  // covered by the marker and less saturated, so they weigh less than in the binary centroid.
+
+  const cv::Rect box(stats.at<int>(best, cv::CC_STAT_LEFT), stats.at<int>(best, cv::CC_STAT_TOP),
+                     stats.at<int>(best, cv::CC_STAT_WIDTH), stats.at<int>(best, cv::CC_STAT_HEIGHT));
+
+  double sum_w = 0.0;
+  double sum_x = 0.0;
+  double sum_y = 0.0;
+
+  for (int y = box.y; y < box.y + box.height; y++) {
+    const auto* label = labels.ptr<int>(y);
+    const auto* p = hsv.ptr<uchar>(y);
+
+    double row_w = 0.0;
+    double row_x = 0.0;
+
+    for (int x = box.x; x < box.x + box.width; x++) {
+      const double w = (label[x] == best) ? p[(3 * x) + 1] : 0.0;
+
+      row_w += w;
+      row_x += w * x;
+    }
+
+    sum_w += row_w;
+    sum_x += row_x;
+    sum_y += row_w * y;
+  }
+
+  if (sum_w <= 0.0) {
+    return false;
+  }
+
+  // pixel x covers [x, x + 1). Its center is at x + 0.5
+
+  const double xc = search.x + (sum_x / sum_w) + 0.5;
+  const double yc = search.y + (sum_y / sum_w) + 0.5;
+
+  roi.x = xc - (roi.width * 0.5);
+  roi.y = yc - (roi.height * 0.5);
+
+  return true;
+}
+
+void MarkerEngine::threshold() {
+  mask.create(hsv.size(), CV_8UC1);
+
+  const int tolerance = options.hue_tolerance;
+  const int min_s = options.min_saturation;
+  const int min_v = options.min_value;
+
+  // Branch free row scans. The hue distance wraps around because red is at both ends of the range.
+
+  for (int y = 0; y < hsv.rows; y++) {
+    const auto* p = hsv.ptr<uchar>(y);
+
+    auto* m = mask.ptr<uchar>(y);
+
+    for (int x = 0; x < hsv.cols; x++) {
+      const int d = std::abs(p[3 * x] - hue);
+      const int distance = std::min(d, hue_range - d);
+
+      const bool inside = (distance <= tolerance) & (p[(3 * x) + 1] >= min_s) & (p[(3 * x) + 2] >= min_v);
+
+      m[x] = inside ? 255 : 0;
+    }
+  }
+}
+
+}  // namespace tracker
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include "tracker_engine.hpp"
+
+namespace tracker {
+
+struct MarkerOptions {
+  int hue_tolerance = 12;  // OpenCV hue units, 0 to 179
+
+  int min_saturation = 80;
+
+  int min_value = 60;
+};
+
+/*
+  Tracks a bright colored sticker instead of running a correlation tracker. The marker hue is learned from the pixels
+  of the roi when it is created. At each update only a window around the previous roi is converted to HSV and
+  thresholded. The marker is the connected component closest to the previous position and its centroid, weighted by
+  the saturation, gives a subpixel position. The roi keeps its size and is centered on it.
+*/
+
+class MarkerEngine : public TrackerEngine {
+ public:
+  MarkerEngine(int algorithm, MarkerOptions options);
+
+ protected:
+  void do_init(const cv::Mat& image, const cv::Rect2d& roi) override;
+
+  auto do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool override;
+
+ private:
+  MarkerOptions options;
+
+  int hue = -1;  // -1 when no pixel of the initial roi was colored enough
+
+  cv::Mat hsv;
+  cv::Mat mask;
+  cv::Mat labels;
+  cv::Mat stats;
+  cv::Mat centroids;
+
+  void threshold();
+};
+
+}  // namespace tracker
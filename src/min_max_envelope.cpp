@@ -0,0 +1,162 @@
+#include "min_max_envelope.hpp"
+#include <qlist.h>
+#include <qpoint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace util {
+
+auto MinMaxEnvelope::configure(size_t window_samples, size_t n_columns) -> bool {
+  n_columns = std::max<size_t>(n_columns, 1U);
+
+  const auto size = std::max<size_t>((window_samples + n_columns - 1U) / n_columns, 1U);
+
+  window = window_samples;
+
+  if (size == column_size) {
+    return false;
+  }
+
+  column_size = size;
+
+  clear();
+
+  return true;
+}
+
+void MinMaxEnvelope::push(double x, double y) {
+  const QPointF p(x, y);
+
+  if (n_partial == 0U) {
+    partial = Column{.first_index = n_pushed, .min = p, .max = p};
+  } else if (std::isnan(partial.min.y())) {
+    // missing samples only take space in the column. The first valid one replaces them
+
+    partial.min = p;
+    partial.max = p;
+  } else {
+    if (y < partial.min.y()) {
+      partial.min = p;
+    }
+
+    if (y > partial.max.y()) {
+      partial.max = p;
+    }
+  }
+
+  n_pushed++;
+  n_partial++;
+
+  if (n_partial == column_size) {
+    columns.push_back(partial);
+
+    n_partial = 0;
+  }
+
+  // the first sample still inside the window decides which columns are gone
+
+  const auto first_kept = (n_pushed > window) ? n_pushed - window : 0U;
+
+  while (!columns.empty() && columns.front().first_index + column_size <= first_kept) {
+    columns.pop_front();
+  }
+}
+
+void MinMaxEnvelope::clear() {
+  n_partial = 0;
+  n_pushed = 0;
+
+  columns.clear();
+}
+
+void MinMaxEnvelope::fill(QList<QPointF>& points) const {
+  points.clear();
+
+  points.reserve(static_cast<qsizetype>(2U * (columns.size() + 1U)));
+
+  for (const auto& c : columns) {
+    append_column(c, points);
+  }
+
+  if (n_partial > 0U) {
+    append_column(partial, points);
+  }
+}
+
+void MinMaxEnvelope::append_column(const Column& column, QList<QPointF>& points) {
+  if (std::isnan(column.min.y())) {
+    return;  // all the samples of the column are missing
+  }
+
+  // the extremes are added in the order they happened so the line does not go back in time
+
+  if (column.min.x() <= column.max.x()) {
+    points.append(column.min);
+    points.append(column.max);
+  } else {
+    points.append(column.max);
+    points.append(column.min);
+  }
+}
+
+void MinMaxEnvelope::decimate(std::span<const QPointF> points,
+                              size_t n_columns,
+                              bool log_x,
+                              QList<QPointF>& output) {
+  output.clear();
+
+  n_columns = std::max<size_t>(n_columns, 1U);
+
+  if (points.size() <= 2U * n_columns) {
+    output.reserve(static_cast<qsizetype>(points.size()));
+
+    for (const auto& p : points) {
+      output.append(p);
+    }
+
+    return;
+  }
+
+  output.reserve(static_cast<qsizetype>(2U * n_columns));
+
+  auto position = [&](double x) { return log_x ? std::log(std::max(x, std::numeric_limits<double>::min())) : x; };
+
+  const double x0 = position(points.front().x());
+  const double width = position(points.back().x()) - x0;
+
+  const double scale = (width > 0.0) ? static_cast<double>(n_columns) / width : 0.0;
+
+  size_t current = n_columns;  // no column yet
+
+  Column column;
+
+  for (const auto& p : points) {
+    const auto n = std::min(static_cast<size_t>(std::max((position(p.x()) - x0) * scale, 0.0)), n_columns - 1U);
+
+    if (n != current) {
+      if (current != n_columns) {
+        append_column(column, output);
+      }
+
+      current = n;
+
+      column = Column{.min = p, .max = p};
+    } else {
+      if (p.y() < column.min.y()) {
+        column.min = p;
+      }
+
+      if (p.y() > column.max.y()) {
+        column.max = p;
+      }
+    }
+  }
+
+  append_column(column, output);
+}
+
+}  // namespace util
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <qlist.h>
+#include <qpoint.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+
+namespace util {
+
+/*
+  Display envelope of a stream whose x values grow monotonically. Consecutive samples are grouped in columns of a
+  fixed number of samples, ideally one column per pixel of the chart, and only the minimum and the maximum of each
+  column are kept. Columns are completed as the samples arrive and removed once they leave the window. So the cost of
+  keeping the envelope does not depend on the window length and the chart always gets at most two points per column.
+*/
+
+class MinMaxEnvelope {
+ public:
+  // returns true when the column width changed and the envelope was cleared. The caller should push the window again
+
+  auto configure(size_t window_samples, size_t n_columns) -> bool;
+
+  // a NaN y marks a missing sample. Columns without valid samples are left out of the chart
+
+  void push(double x, double y);
+
+  void clear();
+
+  void fill(QList<QPointF>& points) const;
+
+  /*
+    One shot version for series that are recomputed as a whole, like the spectrum. The points must be sorted by x.
+    The x range is split in n_columns columns, uniformly in log(x) when log_x is set, and each column contributes its
+    minimum and maximum. Series that already fit are copied as they are.
+  */
+
+  static void decimate(std::span<const QPointF> points, size_t n_columns, bool log_x, QList<QPointF>& output);
+
+ private:
+  struct Column {
+    uint64_t first_index = 0;
+
+    QPointF min;
+    QPointF max;
+  };
+
+  size_t window = 0;
+  size_t column_size = 1;
+  size_t n_partial = 0;
+
+  uint64_t n_pushed = 0;
+
+  Column partial;
+
+  std::deque<Column> columns;
+
+  static void append_column(const Column& column, QList<QPointF>& points);
+};
+
+}  // namespace util
@@ -0,0 +1,450 @@
+#include "mosse_batch.hpp"
+#include <fftw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/imgproc.hpp>
+#include <span>
+#include "fft.hpp"
+#include "tracker_engine.hpp"
+
+namespace tracker {
+
+// Values from Bolme et al., "Visual Object Tracking using Adaptive Correlation Filters", also used by OpenCV's MOSSE
+
+constexpr double learning_rate = 0.125;
+constexpr double target_sigma = 2.0;
+constexpr double psr_threshold = 5.7;
+constexpr int sidelobe_exclusion = 5;  // half size of the area around the peak left out of the sidelobe
+
+MosseBatch::MosseBatch() {
+  // power of two sizes are the fastest ones for fftw
+
+  int side = 32;
+
+  for (auto& group : groups) {
+    group.side = side;
+
+    side *= 2;
+  }
+}
+
+MosseBatch::~MosseBatch() {
+  for (auto& group : groups) {
+    destroy(group);
+  }
+}
+
+void MosseBatch::add(MosseEngine& engine, cv::Rect2d& roi, bool init) {
+  queued.push_back({.engine = &engine, .roi = &roi, .init = init});
+}
+
+void MosseBatch::run(const cv::Mat& gray) {
+  if (queued.empty()) {
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  run(queued, gray);
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  // the batch cost is shared by the filters that were updated. Initializations are not timed by the other engines
+
+  const auto n_updates = std::ranges::count_if(queued, [](const MosseTask& t) { return !t.init; });
+
+  if (n_updates > 0) {
+    const auto ns = static_cast<uint64_t>(elapsed.count()) / static_cast<uint64_t>(n_updates);
+
+    for (const auto& task : queued) {
+      if (!task.init) {
+        task.engine->record_update(ns);
+      }
+    }
+  }
+
+  queued.clear();
+}
+
+void MosseBatch::run(std::span<MosseTask> tasks, const cv::Mat& gray) {
+  for (auto& task : tasks) {
+    if (!task.init) {
+      continue;
+    }
+
+    auto& filter = task.engine->filter;
+    const auto& roi = *task.roi;
+
+    filter.size = roi.size();
+    filter.center = {roi.x + (roi.width * 0.5), roi.y + (roi.height * 0.5)};
+
+    // The search window is twice the roi. The smallest patch holding it is used, or the largest one scaled down.
+
+    const double extent = 2.0 * std::max({roi.width, roi.height, 1.0});
+
+    const auto it = std::ranges::find_if(groups, [&](const Group& g) { return g.side >= extent; });
+
+    filter.side = (it != groups.end()) ? it->side : groups.back().side;
+    filter.scale = std::max(1.0, extent / filter.side);
+  }
+
+  for (auto& group : groups) {
+    members.clear();
+
+    for (auto& task : tasks) {
+      if (task.engine->filter.side == group.side) {
+        task.found = true;
+
+        members.push_back(&task);
+      }
+    }
+
+    if (members.empty()) {
+      continue;
+    }
+
+    prepare(group, static_cast<int>(members.size()));
+
+    detect(group, gray);
+
+    learn(group, gray);
+  }
+}
+
+void MosseBatch::prepare(Group& group, int count) {
+  if (group.count == count) {
+    return;
+  }
+
+  destroy(group);
+
+  const auto side = group.side;
+  const auto n_real = static_cast<size_t>(side) * static_cast<size_t>(side);
+  const auto n_freq = static_cast<size_t>(side) * static_cast<size_t>((side / 2) + 1);
+
+  group.real = fftw_alloc_real(n_real * static_cast<size_t>(count));
+  group.spectrum = fftw_alloc_complex(n_freq * static_cast<size_t>(count));
+
+  const std::array<int, 2> dims = {side, side};
+
+  std::lock_guard<std::mutex> planner_lock_guard(sound::fftw_planner_mutex());
+
+  // The patches are stored one after the other. FFTW_ESTIMATE does not touch the arrays and plans quickly, which
+  // matters because the plans are made again whenever the number of ROIs changes.
+
+  group.forward = fftw_plan_many_dft_r2c(2, dims.data(), count, group.real, nullptr, 1, static_cast<int>(n_real),
+                                         group.spectrum, nullptr, 1, static_cast<int>(n_freq), FFTW_ESTIMATE);
+
+  group.inverse = fftw_plan_many_dft_c2r(2, dims.data(), count, group.spectrum, nullptr, 1, static_cast<int>(n_freq),
+                                         group.real, nullptr, 1, static_cast<int>(n_real), FFTW_ESTIMATE);
+
+  group.count = count;
+
+  if (!group.target.empty()) {
+    return;
+  }
+
+  cv::createHanningWindow(group.window, cv::Size(side, side), CV_32F);
+
+  // gaussian peak in the middle of the patch. A response peaking there means the target did not move
+
+  auto* gaussian = fftw_alloc_real(n_real);
+  auto* transform = fftw_alloc_complex(n_freq);
+
+  auto plan = fftw_plan_dft_r2c_2d(side, side, gaussian, transform, FFTW_ESTIMATE);
+
+  for (int y = 0; y < side; y++) {
+    for (int x = 0; x < side; x++) {
+      const double dx = x - (side / 2);
+      const double dy = y - (side / 2);
+
+      gaussian[(y * side) + x] = std::exp(-((dx * dx) + (dy * dy)) / (2.0 * target_sigma * target_sigma));
+    }
+  }
+
+  fftw_execute(plan);
+
+  group.target.assign(reinterpret_cast<std::complex<double>*>(transform),
+                      reinterpret_cast<std::complex<double>*>(transform) + n_freq);
+
+  fftw_destroy_plan(plan);
+  fftw_free(gaussian);
+  fftw_free(transform);
+}
+
+void MosseBatch::destroy(Group& group) {
+  {
+    std::lock_guard<std::mutex> planner_lock_guard(sound::fftw_planner_mutex());
+
+    if (group.forward != nullptr) {
+      fftw_destroy_plan(group.forward);
+    }
+
+    if (group.inverse != nullptr) {
+      fftw_destroy_plan(group.inverse);
+    }
+  }
+
+  fftw_free(group.real);
+  fftw_free(group.spectrum);
+
+  group.forward = nullptr;
+  group.inverse = nullptr;
+  group.real = nullptr;
+  group.spectrum = nullptr;
+  group.count = 0;
+}
+
+void MosseBatch::load_patch(const Group& group, const MosseFilter& filter, const cv::Mat& gray, int slot) {
+  const auto side = group.side;
+
+  const cv::Point2f center(static_cast<float>(filter.center.x), static_cast<float>(filter.center.y));
+
+  // pixels outside of the image are replicated from the border
+
+  if (filter.scale > 1.0) {
+    const auto extent = cvRound(side * filter.scale);
+
+    cv::getRectSubPix(gray, cv::Size(extent, extent), center, resized, CV_32F);
+
+    cv::resize(resized, patch, cv::Size(side, side), 0, 0, cv::INTER_AREA);
+  } else {
+    cv::getRectSubPix(gray, cv::Size(side, side), center, patch, CV_32F);
+  }
+
+  // the log reduces the effect of the lighting. Then the patch is normalized and multiplied by the cosine window
+
+  cv::log(patch + 1.0F, patch);
+
+  cv::Scalar mean;
+  cv::Scalar stddev;
+
+  cv::meanStdDev(patch, mean, stddev);
+
+  const double norm = 1.0 / (stddev[0] + 1.0e-5);
+
+  patch.convertTo(patch, CV_32F, norm, -mean[0] * norm);
+
+  cv::Mat destination(side, side, CV_64F, group.real + (static_cast<ptrdiff_t>(slot) * side * side));
+
+  cv::multiply(patch, group.window, destination, 1.0, CV_64F);
+}
+
+void MosseBatch::detect(Group& group, const cv::Mat& gray) {
+  const auto side = group.side;
+  const auto n_real = static_cast<size_t>(side) * static_cast<size_t>(side);
+  const auto n_freq = static_cast<size_t>(side) * static_cast<size_t>((side / 2) + 1);
+
+  bool any = false;
+
+  for (size_t k = 0; k < members.size(); k++) {
+    if (!members[k]->init) {
+      load_patch(group, members[k]->engine->filter, gray, static_cast<int>(k));
+
+      any = true;
+    }
+  }
+
+  if (!any) {
+    return;
+  }
+
+  fftw_execute(group.forward);
+
+  auto* spectrum = reinterpret_cast<std::complex<double>*>(group.spectrum);
+
+  // correlation with the filter H* = A / B
+
+  for (size_t k = 0; k < members.size(); k++) {
+    if (members[k]->init) {
+      continue;
+    }
+
+    const auto& filter = members[k]->engine->filter;
+
+    auto* s = spectrum + (k * n_freq);
+
+    for (size_t i = 0; i < n_freq; i++) {
+      s[i] *= filter.numerator[i] / filter.denominator[i];
+    }
+  }
+
+  fftw_execute(group.inverse);
+
+  for (size_t k = 0; k < members.size(); k++) {
+    auto& task = *members[k];
+
+    if (task.init) {
+      continue;
+    }
+
+    auto& filter = task.engine->filter;
+
+    const double* response = group.real + (k * n_real);
+
+    cv::Mat response_mat(side, side, CV_64F, const_cast<double*>(response));
+
+    double peak = 0.0;
+
+    cv::Point location;
+
+    cv::minMaxLoc(response_mat, nullptr, &peak, nullptr, &location);
+
+    // peak to sidelobe ratio. A low value means the target is not in the search window anymore
+
+    double sum = 0.0;
+    double sum_squares = 0.0;
+
+    for (size_t i = 0; i < n_real; i++) {
+      sum += response[i];
+      sum_squares += response[i] * response[i];
+    }
+
+    const int x0 = std::max(location.x - sidelobe_exclusion, 0);
+    const int x1 = std::min(location.x + sidelobe_exclusion, side - 1);
+    const int y0 = std::max(location.y - sidelobe_exclusion, 0);
+    const int y1 = std::min(location.y + sidelobe_exclusion, side - 1);
+
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        const double v = response[(y * side) + x];
+
+        sum -= v;
+        sum_squares -= v * v;
+      }
+    }
+
+    const double n_sidelobe = static_cast<double>(n_real) - static_cast<double>((x1 - x0 + 1) * (y1 - y0 + 1));
+    const double mean = sum / n_sidelobe;
+    const double deviation = std::sqrt(std::max((sum_squares / n_sidelobe) - (mean * mean), 1.0e-12));
+
+    if ((peak - mean) / deviation < psr_threshold) {
+      task.found = false;
+
+      continue;
+    }
+
+    // subpixel position from a parabola through the peak and its neighbors
+
+    auto refine = [](double before, double center, double after) {
+      const double curvature = before - (2.0 * center) + after;
+
+      return curvature < 0.0 ? 0.5 * (before - after) / curvature : 0.0;
+    };
+
+    double px = location.x;
+    double py = location.y;
+
+    if (location.x > 0 && location.x < side - 1) {
+      px += refine(response_mat.at<double>(location.y, location.x - 1), peak,
+                   response_mat.at<double>(location.y, location.x + 1));
+    }
+
+    if (location.y > 0 && location.y < side - 1) {
+      py += refine(response_mat.at<double>(location.y - 1, location.x), peak,
+                   response_mat.at<double>(location.y + 1, location.x));
+    }
+
+    filter.center.x += (px - (side / 2)) * filter.scale;
+    filter.center.y += (py - (side / 2)) * filter.scale;
+
+    *task.roi = cv::Rect2d(filter.center.x - (filter.size.width * 0.5), filter.center.y - (filter.size.height * 0.5),
+                           filter.size.width, filter.size.height);
+  }
+}
+
+void MosseBatch::learn(Group& group, const cv::Mat& gray) {
+  const auto side = group.side;
+  const auto n_real = static_cast<size_t>(side) * static_cast<size_t>(side);
+  const auto n_freq = static_cast<size_t>(side) * static_cast<size_t>((side / 2) + 1);
+
+  // Keeps the division in A / B stable where the patches have little energy. It is small next to the mean power of
+  // a normalized and windowed patch, which is a fraction of n_real.
+
+  const double regularization = 1.0e-3 * static_cast<double>(n_real);
+
+  bool any = false;
+
+  for (size_t k = 0; k < members.size(); k++) {
+    if (members[k]->found) {
+      load_patch(group, members[k]->engine->filter, gray, static_cast<int>(k));
+
+      any = true;
+    }
+  }
+
+  if (!any) {
+    return;
+  }
+
+  fftw_execute(group.forward);
+
+  const auto* spectrum = reinterpret_cast<const std::complex<double>*>(group.spectrum);
+
+  for (size_t k = 0; k < members.size(); k++) {
+    const auto& task = *members[k];
+
+    if (!task.found) {
+      continue;
+    }
+
+    auto& filter = task.engine->filter;
+
+    const auto* s = spectrum + (k * n_freq);
+
+    if (task.init) {
+      filter.numerator.resize(n_freq);
+      filter.denominator.resize(n_freq);
+
+      for (size_t i = 0; i < n_freq; i++) {
+        filter.numerator[i] = group.target[i] * std::conj(s[i]);
+        filter.denominator[i] = std::norm(s[i]) + regularization;
+      }
+    } else {
+      for (size_t i = 0; i < n_freq; i++) {
+        filter.numerator[i] = (learning_rate * group.target[i] * std::conj(s[i])) +
+                              ((1.0 - learning_rate) * filter.numerator[i]);
+
+        filter.denominator[i] =
+            (learning_rate * (std::norm(s[i]) + regularization)) + ((1.0 - learning_rate) * filter.denominator[i]);
+      }
+    }
+  }
+}
+
+MosseEngine::MosseEngine(int algorithm) : TrackerEngine(algorithm) {}
+
+void MosseEngine::do_init(const cv::Mat& image, const cv::Rect2d& roi) {
+  if (!own_batch) {
+    own_batch = std::make_unique<MosseBatch>();
+  }
+
+  auto box = roi;
+
+  MosseTask task{.engine = this, .roi = &box, .init = true};
+
+  own_batch->run(std::span(&task, 1), image);
+}
+
+auto MosseEngine::do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool {
+  if (!own_batch || filter.numerator.empty()) {
+    return false;
+  }
+
+  MosseTask task{.engine = this, .roi = &roi};
+
+  own_batch->run(std::span(&task, 1), image);
+
+  return task.found;
+}
+
+}  // namespace tracker
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <fftw3.h>
+#include <array>
+#include <complex>
+#include <memory>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <span>
+#include <vector>
+#include "tracker_engine.hpp"
+
+namespace tracker {
+
+// State of one MOSSE correlation filter. It is only touched by the MosseBatch updating it.
+
+struct MosseFilter {
+  int side = 0;  // the patch is side x side pixels. All the filters with the same side share the fftw plans
+
+  double scale = 1.0;  // image pixels per patch pixel
+
+  cv::Point2d center;
+
+  cv::Size2d size;  // of the roi in image pixels
+
+  std::vector<std::complex<double>> numerator;    // A in Bolme's paper
+  std::vector<std::complex<double>> denominator;  // B in Bolme's paper
+};
+
+class MosseEngine;
+
+struct MosseTask {
+  MosseEngine* engine = nullptr;
+
+  cv::Rect2d* roi = nullptr;
+
+  bool init = false;
+
+  bool found = true;  // set by MosseBatch::run
+};
+
+/*
+  MOSSE correlation filters of many ROIs updated together on one thread. The patches are resampled to a few square
+  sizes and the filters with the same size are transformed by a single fftw plan covering all of them. The
+  preprocessing (log, normalization and cosine window) uses the OpenCV functions working on whole images, which are
+  vectorized. A frame costs two batched forward transforms and one batched inverse per patch size.
+*/
+
+class MosseBatch {
+ public:
+  MosseBatch();
+
+  MosseBatch(const MosseBatch&) = delete;
+  auto operator=(const MosseBatch&) -> MosseBatch& = delete;
+
+  ~MosseBatch();
+
+  // queues a filter for the next run(gray). The roi is updated in place
+
+  void add(MosseEngine& engine, cv::Rect2d& roi, bool init);
+
+  // Runs the queued filters and shares the time spent among the updated ones. The image has to be the 8 bit
+  // grayscale one.
+
+  void run(const cv::Mat& gray);
+
+  void run(std::span<MosseTask> tasks, const cv::Mat& gray);
+
+ private:
+  struct Group {
+    int side = 0;
+    int count = 0;  // transforms done by each plan execution
+
+    double* real = nullptr;
+
+    fftw_complex* spectrum = nullptr;
+
+    fftw_plan forward = nullptr;
+    fftw_plan inverse = nullptr;
+
+    cv::Mat window;  // cosine window, CV_32F
+
+    std::vector<std::complex<double>> target;  // transform of the desired gaussian response
+  };
+
+  std::array<Group, 3> groups;  // by increasing patch size
+
+  std::vector<MosseTask> queued;
+
+  std::vector<MosseTask*> members;  // tasks of the group being processed. Their index is the slot in the buffers
+
+  cv::Mat patch;
+  cv::Mat resized;
+
+  void prepare(Group& group, int count);
+  void destroy(Group& group);
+  void load_patch(const Group& group, const MosseFilter& filter, const cv::Mat& gray, int slot);
+  void detect(Group& group, const cv::Mat& gray);
+  void learn(Group& group, const cv::Mat& gray);
+};
+
+/*
+  Tracker engine with a MOSSE filter meant to be updated in batches by update_trackers. When it is used alone, like
+  in the backfill of new ROIs, it runs a batch of one with its own plans.
+*/
+
+class MosseEngine : public TrackerEngine {
+ public:
+  explicit MosseEngine(int algorithm);
+
+  MosseFilter filter;
+
+ protected:
+  void do_init(const cv::Mat& image, const cv::Rect2d& roi) override;
+
+  auto do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool override;
+
+ private:
+  std::unique_ptr<MosseBatch> own_batch;
+};
+
+}  // namespace tracker
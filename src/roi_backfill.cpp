@@ -0,0 +1,238 @@
+#include "roi_backfill.hpp"
+#include <qtypes.h>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <opencv2/core/base.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/imgproc.hpp>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "frame_history.hpp"
+#include "roi_tracker.hpp"
+#include "util.hpp"
+
+namespace tracker {
+
+RoiBackfill::RoiBackfill(FrameHistory& history, std::function<void(BackfillJob&)> callback)
+    : history(history), callback(std::move(callback)) {
+  worker = std::thread([this]() { work(); });
+}
+
+RoiBackfill::~RoiBackfill() {
+  stop();
+}
+
+void RoiBackfill::submit(BackfillJob job) {
+  {
+    std::lock_guard<std::mutex> jobs_lock_guard(jobs_mutex);
+
+    if (!running) {
+      return;
+    }
+
+    jobs.push_back(std::move(job));
+  }
+
+  jobs_cv.notify_one();
+}
+
+void RoiBackfill::stop() {
+  {
+    std::lock_guard<std::mutex> jobs_lock_guard(jobs_mutex);
+
+    running = false;
+
+    jobs.clear();
+  }
+
+  jobs_cv.notify_all();
+
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void RoiBackfill::work() {
+  while (true) {
+    BackfillJob job;
+
+    {
+      std::unique_lock<std::mutex> lock(jobs_mutex);
+
+      jobs_cv.wait(lock, [this] { return !running || !jobs.empty(); });
+
+      if (!running) {
+        return;
+      }
+
+      job = std::move(jobs.front());
+
+      jobs.pop_front();
+    }
+
+    const auto drawn_roi = job.roi_tracker.roi;
+
+    try {
+      run(job);
+    } catch (const cv::Exception& e) {
+      // The history is given up for this ROI. Its tracker starts on the next live frame instead.
+
+      util::warning("ROI " + util::to_string(job.roi_tracker.id) +
+                    ": tracking over the frame history failed: " + e.what());
+
+      job.samples.clear();
+
+      job.roi_tracker.tracker = create_tracker(job.algorithm, job.engines);
+      job.roi_tracker.roi = drawn_roi;
+      job.roi_tracker.initialized = false;
+
+      job.scale = {1.0, 1.0};
+    }
+
+    callback(job);
+  }
+}
+
+auto RoiBackfill::load(uint64_t sequence, bool use_color, qint64& time_us, cv::Point2d& scale) -> const cv::Mat* {
+  if (!history.copy(sequence, image, time_us, scale)) {
+    return nullptr;
+  }
+
+  // The history is kept in gray when the algorithm selected does not use color. It may have changed since.
+
+  if (use_color == (image.channels() == 3)) {
+    return &image;
+  }
+
+  cv::cvtColor(image, converted, use_color ? cv::COLOR_GRAY2BGR : cv::COLOR_BGR2GRAY);
+
+  return &converted;
+}
+
+auto RoiBackfill::sample(const BackfillJob& job, qint64 time_us, const cv::Rect2d& roi) -> TimedPosition {
+  const auto [xc, yc] = roi_center(scale_roi(roi, {1.0 / job.scale.x, 1.0 / job.scale.y}), job.frame_height);
+
+  return {.time_us = time_us, .x = xc, .y = yc};
+}
+
+void RoiBackfill::run(BackfillJob& job) {
+  auto& [tracker, roi, initialized, use_color, trajectory, id] = job.roi_tracker;
+
+  qint64 time_us = 0;
+
+  cv::Point2d scale;
+
+  const auto* image = load(job.start_sequence, use_color, time_us, scale);
+
+  if (image == nullptr) {
+    // The image was evicted before the job started. The tracker will be initialized on the next frame like it
+    // happens when there is no history.
+
+    job.next_sequence = job.start_sequence;
+
+    return;
+  }
+
+  job.scale = scale;
+
+  roi = scale_roi(roi, scale);
+
+  const auto drawn_roi = roi;
+
+  tracker->init(*image, roi);
+
+  initialized = true;
+
+  job.samples.push_back(sample(job, time_us, roi));
+
+  job.next_sequence = job.start_sequence + 1;
+
+  // Forward first so the live tracker is close to the newest image when the backend takes it over
+
+  track_forward(job);
+
+  track_backward(job, drawn_roi);
+}
+
+void RoiBackfill::track_forward(BackfillJob& job) {
+  auto& [tracker, roi, initialized, use_color, trajectory, id] = job.roi_tracker;
+
+  if (!initialized) {
+    return;
+  }
+
+  if (const auto first = history.first_sequence(); job.next_sequence < first) {
+    // The tracker could not keep up with the video. It continues from the oldest image still available.
+
+    util::warning("ROI " + util::to_string(id) + ": " + util::to_string(first - job.next_sequence) +
+                  " frames were evicted before they could be tracked");
+
+    job.next_sequence = first;
+  }
+
+  qint64 time_us = 0;
+
+  cv::Point2d scale;
+
+  while (const auto* image = load(job.next_sequence, use_color, time_us, scale)) {
+    if (scale != job.scale) {
+      break;  // a new history started with images reduced differently. The live frames take over from here
+    }
+
+    tracker->update(*image, roi);
+
+    job.samples.push_back(sample(job, time_us, roi));
+
+    job.next_sequence++;
+  }
+}
+
+void RoiBackfill::track_backward(BackfillJob& job, cv::Rect2d roi) {
+  auto backward_tracker = create_tracker(job.algorithm, job.engines);
+
+  const auto use_color = job.roi_tracker.use_color;
+
+  qint64 time_us = 0;
+
+  cv::Point2d scale;
+
+  const auto* image = load(job.start_sequence, use_color, time_us, scale);
+
+  if (backward_tracker.empty() || image == nullptr) {
+    return;
+  }
+
+  backward_tracker->init(*image, roi);
+
+  std::vector<TimedPosition> past;
+
+  bool lost = false;
+
+  for (auto sequence = job.start_sequence; sequence > 0U; sequence--) {
+    image = load(sequence - 1U, use_color, time_us, scale);
+
+    if (image == nullptr) {
+      break;  // reached the oldest image
+    }
+
+    // Once lost the tracker does not find the target again on its own. The remaining positions are left missing.
+
+    lost = lost || !backward_tracker->update(*image, roi);
+
+    if (lost) {
+      past.push_back({.time_us = time_us,
+                      .x = std::numeric_limits<double>::quiet_NaN(),
+                      .y = std::numeric_limits<double>::quiet_NaN()});
+    } else {
+      past.push_back(sample(job, time_us, roi));
+    }
+  }
+
+  job.samples.insert(job.samples.begin(), past.rbegin(), past.rend());
+}
+
+}  // namespace tracker
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <qtypes.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <thread>
+#include <vector>
+#include "frame_history.hpp"
+#include "roi_tracker.hpp"
+
+namespace tracker {
+
+struct TimedPosition {
+  qint64 time_us = 0;
+
+  double x = 0.0;
+  double y = 0.0;
+};
+
+struct BackfillJob {
+  // Not initialized yet. Its roi was drawn on the image start_sequence. It is given in analysis pixels and is in the
+  // pixels of the history images once the job started.
+
+  RoiTracker roi_tracker;
+
+  int algorithm = 0;
+  int frame_height = 0;  // of the analysis images
+
+  EngineSettings engines;
+
+  cv::Point2d scale = {1.0, 1.0};  // history pixels per analysis pixel
+
+  uint64_t start_sequence = 0;
+  uint64_t next_sequence = 0;  // first image the live tracker did not process yet
+
+  std::vector<TimedPosition> samples;  // chronological
+};
+
+/*
+  Brings an ROI created in the middle of a video up to date without replaying it. A background thread initializes
+  the tracker on the image the ROI was drawn on and runs it forward over the images that arrived since. A second
+  tracker of the same kind runs backward over the older images in the history, so the new ROI also gets the past
+  positions the other trackers already have. The samples are given in analysis pixels. Jobs are done in the order
+  they were submitted. The callback gets the finished job and has to call track_forward() once more under its own
+  lock before using the tracker. When the tracking over the history fails the job comes back without samples and
+  with a tracker that is not initialized.
+*/
+
+class RoiBackfill {
+ public:
+  RoiBackfill(FrameHistory& history, std::function<void(BackfillJob&)> callback);
+
+  RoiBackfill(const RoiBackfill&) = delete;
+  auto operator=(const RoiBackfill&) -> RoiBackfill& = delete;
+
+  ~RoiBackfill();
+
+  void submit(BackfillJob job);
+
+  void stop();
+
+  // runs the live tracker over the images pushed after job.next_sequence
+
+  void track_forward(BackfillJob& job);
+
+ private:
+  bool running = true;
+
+  FrameHistory& history;
+
+  std::function<void(BackfillJob&)> callback;
+
+  std::deque<BackfillJob> jobs;
+
+  std::mutex jobs_mutex;
+
+  std::condition_variable jobs_cv;
+
+  std::thread worker;
+
+  cv::Mat image;
+  cv::Mat converted;  // image in the other color format
+
+  void work();
+  void run(BackfillJob& job);
+  void track_backward(BackfillJob& job, cv::Rect2d roi);
+  auto load(uint64_t sequence, bool use_color, qint64& time_us, cv::Point2d& scale) -> const cv::Mat*;
+
+  static auto sample(const BackfillJob& job, qint64 time_us, const cv::Rect2d& roi) -> TimedPosition;
+};
+
+}  // namespace tracker
@@ -0,0 +1,263 @@
+#include "roi_tracker.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <opencv2/core/base.hpp>
+#include <opencv2/core/cvstd_wrapper.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/core/version.hpp>
+#include <opencv2/dnn.hpp>
+#include <opencv2/tracking.hpp>
+#include <opencv2/tracking/tracking_legacy.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "eyeofsauron_db.h"
+#include "marker_engine.hpp"
+#include "mosse_batch.hpp"
+#include "thread_pool.hpp"
+#include "tracker_engine.hpp"
+#include "util.hpp"
+
+namespace tracker {
+
+constexpr double min_search_padding = 16.0;  // pixels added on each side of the search windows
+
+auto read_engine_settings() -> EngineSettings {
+  return {.nano_backbone = db::Main::nanoBackbonePath().toStdString(),
+          .nano_neckhead = db::Main::nanoNeckheadPath().toStdString(),
+          .vit_model = db::Main::vitModelPath().toStdString(),
+          .dasiamrpn_model = db::Main::dasiamrpnModelPath().toStdString(),
+          .dasiamrpn_kernel_cls1 = db::Main::dasiamrpnKernelCls1Path().toStdString(),
+          .dasiamrpn_kernel_r1 = db::Main::dasiamrpnKernelR1Path().toStdString(),
+          .marker = {.hue_tolerance = db::Main::markerHueTolerance(),
+                     .min_saturation = db::Main::markerMinSaturation(),
+                     .min_value = db::Main::markerMinValue()}};
+}
+
+auto create_tracker(int algorithm, const EngineSettings& settings) -> cv::Ptr<TrackerEngine> {
+  using algo = db::Main::EnumTrackingAlgorithm;
+
+  // the networks are loaded when the tracker is created. A missing or invalid file throws
+
+  try {
+    switch (algorithm) {
+      case algo::mosse:
+        return cv::makePtr<LegacyEngine>(algorithm, cv::legacy::TrackerMOSSE::create());
+      case algo::kcf:
+        return cv::makePtr<LegacyEngine>(algorithm, cv::legacy::TrackerKCF::create());
+      case algo::tld:
+        return cv::makePtr<LegacyEngine>(algorithm, cv::legacy::TrackerTLD::create());
+      case algo::mil:
+        return cv::makePtr<LegacyEngine>(algorithm, cv::legacy::TrackerMIL::create());
+      case algo::batchmosse:
+        return cv::makePtr<MosseEngine>(algorithm);
+      case algo::marker:
+        return cv::makePtr<MarkerEngine>(algorithm, settings.marker);
+      case algo::csrt:
+        return cv::makePtr<ModernEngine>(algorithm, cv::TrackerCSRT::create());
+      case algo::nano: {
+        cv::TrackerNano::Params params;
+
+        params.backbone = settings.nano_backbone;
+        params.neckhead = settings.nano_neckhead;
+        params.backend = cv::dnn::DNN_BACKEND_OPENCV;
+        params.target = cv::dnn::DNN_TARGET_CPU;
+
+        return cv::makePtr<ModernEngine>(algorithm, cv::TrackerNano::create(params));
+      }
+      case algo::vit: {
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 9)
+        cv::TrackerVit::Params params;
+
+        params.net = settings.vit_model;
+        params.backend = cv::dnn::DNN_BACKEND_OPENCV;
+        params.target = cv::dnn::DNN_TARGET_CPU;
+
+        return cv::makePtr<ModernEngine>(algorithm, cv::TrackerVit::create(params));
+#else
+        util::warning("The Vit tracker needs OpenCV 4.9 or newer");
+
+        return {};
+#endif
+      }
+      case algo::dasiamrpn: {
+        cv::TrackerDaSiamRPN::Params params;
+
+        params.model = settings.dasiamrpn_model;
+        params.kernel_cls1 = settings.dasiamrpn_kernel_cls1;
+        params.kernel_r1 = settings.dasiamrpn_kernel_r1;
+        params.backend = cv::dnn::DNN_BACKEND_OPENCV;
+        params.target = cv::dnn::DNN_TARGET_CPU;
+
+        return cv::makePtr<ModernEngine>(algorithm, cv::TrackerDaSiamRPN::create(params));
+      }
+      default: {
+        util::warning("Unknown tracking algorithm choice!");
+
+        return {};
+      }
+    }
+  } catch (const cv::Exception& e) {
+    util::warning(std::string("Could not create the tracker. Check the model files in the preferences: ") + e.what());
+
+    return {};
+  }
+}
+
+auto algorithm_uses_color(int algorithm) -> bool {
+  const auto* info = engine_info(algorithm);
+
+  return info != nullptr && info->uses_color;
+}
+
+auto trackers_need_gray(std::span<const RoiTracker> trackers) -> bool {
+  return std::ranges::any_of(trackers, [](const RoiTracker& t) { return !t.use_color; });
+}
+
+auto trackers_need_color(std::span<const RoiTracker> trackers) -> bool {
+  return std::ranges::any_of(trackers, [](const RoiTracker& t) { return t.use_color; });
+}
+
+auto search_windows(std::span<const RoiTracker> trackers, const cv::Size& frame_size) -> std::vector<cv::Rect> {
+  const cv::Rect frame(cv::Point(0, 0), frame_size);
+
+  std::vector<cv::Rect> windows;
+
+  for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    if (tracker.empty()) {
+      continue;
+    }
+
+    const auto* info = engine_info(tracker->algorithm());
+
+    if (info == nullptr || info->search_scale <= 0.0) {
+      return {frame};
+    }
+
+    // The padding covers the minimum patch sizes of the engines and the motion of very small targets
+
+    const double padding = min_search_padding + info->search_padding;
+
+    const double side = (info->search_scale * std::max(roi.width, roi.height)) + (2.0 * padding);
+
+    const double x0 = roi.x + (roi.width * 0.5) - (side * 0.5);
+    const double y0 = roi.y + (roi.height * 0.5) - (side * 0.5);
+
+    const cv::Point tl(cvFloor(x0), cvFloor(y0));
+    const cv::Point br(cvCeil(x0 + side), cvCeil(y0 + side));
+
+    if (const auto window = cv::Rect(tl, br) & frame; !window.empty()) {
+      windows.push_back(window);
+    }
+  }
+
+  // Merging overlapping windows until none is left. Their number is small, so the quadratic passes do not matter.
+
+  for (bool merged = true; merged;) {
+    merged = false;
+
+    for (size_t i = 0; i < windows.size() && !merged; i++) {
+      for (size_t j = i + 1; j < windows.size(); j++) {
+        if ((windows[i] & windows[j]).empty()) {
+          continue;
+        }
+
+        windows[i] |= windows[j];
+
+        windows.erase(windows.begin() + static_cast<std::ptrdiff_t>(j));
+
+        merged = true;
+
+        break;
+      }
+    }
+  }
+
+  return windows;
+}
+
+auto is_batched(const cv::Ptr<TrackerEngine>& tracker) -> bool {
+  return tracker->algorithm() == db::Main::EnumTrackingAlgorithm::batchmosse;
+}
+
+void update_trackers(std::span<RoiTracker> trackers,
+                     const cv::Mat& bgr,
+                     const cv::Mat& gray,
+                     util::ThreadPool& pool,
+                     MosseBatch& mosse) {
+  // the batched filters are updated together on the calling thread before the others are spread over the pool
+
+  for (auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    if (!tracker.empty() && is_batched(tracker)) {
+      mosse.add(static_cast<MosseEngine&>(*tracker), roi, !initialized);
+
+      initialized = true;
+    }
+  }
+
+  mosse.run(gray);
+
+  pool.parallel_for(trackers.size(), [&](size_t n) {
+    auto& [tracker, roi, initialized, use_color, trajectory, id] = trackers[n];
+
+    if (tracker.empty() || is_batched(tracker)) {
+      return;  // placeholder of a ROI that is still being tracked over the frame history, or already updated
+    }
+
+    const auto& cv_frame = use_color ? bgr : gray;
+
+    if (!initialized) {
+      tracker->init(cv_frame, roi);
+
+      initialized = true;
+    } else {
+      tracker->update(cv_frame, roi);
+    }
+  });
+}
+
+auto take_timing_report(std::span<RoiTracker> trackers) -> std::string {
+  std::string report;
+
+  for (const auto& info : engine_infos()) {
+    size_t n_rois = 0;
+
+    EngineTiming total;
+
+    for (auto& t : trackers) {
+      if (t.tracker.empty() || t.tracker->algorithm() != info.algorithm) {
+        continue;
+      }
+
+      const auto timing = t.tracker->take_timing();
+
+      total.n_updates += timing.n_updates;
+      total.update_ns += timing.update_ns;
+
+      n_rois++;
+    }
+
+    if (total.n_updates == 0U) {
+      continue;
+    }
+
+    report += std::format("{}{} x{}: {:.2f} ms", report.empty() ? "" : ", ", info.name, n_rois,
+                          static_cast<double>(total.update_ns) / static_cast<double>(total.n_updates) / 1.0e6);
+  }
+
+  return report;
+}
+
+auto roi_center(const cv::Rect2d& roi, int frame_height) -> std::pair<double, double> {
+  return {roi.x + (roi.width * 0.5), frame_height - (roi.y + (roi.height * 0.5))};
+}
+
+auto scale_roi(const cv::Rect2d& roi, cv::Point2d scale) -> cv::Rect2d {
+  return {roi.x * scale.x, roi.y * scale.y, roi.width * scale.x, roi.height * scale.y};
+}
+
+}  // namespace tracker
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <opencv2/core/cvstd_wrapper.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "marker_engine.hpp"
+#include "mosse_batch.hpp"
+#include "thread_pool.hpp"
+#include "tracker_engine.hpp"  // IWYU pragma: export
+#include "trajectory_buffer.hpp"
+
+namespace tracker {
+
+/*
+  Tracking core shared by the interactive backend and the batch mode. It knows nothing about Qt video frames or
+  charts. It only creates the trackers and runs them over OpenCV images.
+*/
+
+struct RoiTracker {
+  cv::Ptr<TrackerEngine> tracker;
+
+  cv::Rect2d roi;
+
+  bool initialized = false;
+
+  bool use_color = true;  // the engine gets the BGR image instead of the grayscale one. See EngineInfo::uses_color
+
+  TrajectoryBuffer trajectory;
+
+  int id = 0;  // stays the same when other ROIs are removed
+};
+
+// Settings of the engines that load networks or take options. The KConfig skeleton is not thread safe, so they are
+// read on the GUI thread and handed to the threads creating trackers.
+
+struct EngineSettings {
+  std::string nano_backbone;
+  std::string nano_neckhead;
+  std::string vit_model;
+  std::string dasiamrpn_model;
+  std::string dasiamrpn_kernel_cls1;
+  std::string dasiamrpn_kernel_r1;
+
+  MarkerOptions marker;
+};
+
+auto read_engine_settings() -> EngineSettings;
+
+// The algorithm is one of the db::Main::EnumTrackingAlgorithm values. An empty pointer is returned for unknown ones
+// and when the network files of a DNN engine cannot be loaded.
+
+auto create_tracker(int algorithm, const EngineSettings& settings) -> cv::Ptr<TrackerEngine>;
+
+auto algorithm_uses_color(int algorithm) -> bool;
+
+auto trackers_need_gray(std::span<const RoiTracker> trackers) -> bool;
+
+auto trackers_need_color(std::span<const RoiTracker> trackers) -> bool;
+
+// Parts of the frame the next update_trackers call reads, in the pixels of the tracking images. Overlapping windows
+// are merged. A single window covering the whole frame is returned when an engine searches everywhere.
+
+auto search_windows(std::span<const RoiTracker> trackers, const cv::Size& frame_size) -> std::vector<cv::Rect>;
+
+// Initializes the new trackers and updates the others. Each tracker owns its state so they run in parallel. The
+// batched MOSSE ones are all updated by the given MosseBatch. Entries without a tracker are skipped.
+
+void update_trackers(std::span<RoiTracker> trackers,
+                     const cv::Mat& bgr,
+                     const cv::Mat& gray,
+                     util::ThreadPool& pool,
+                     MosseBatch& mosse);
+
+// Mean update time of each engine since the previous report, like "KCF x2: 1.35 ms, CSRT x1: 6.10 ms". Empty when no
+// tracker was updated.
+
+auto take_timing_report(std::span<RoiTracker> trackers) -> std::string;
+
+// ROI center with the origin moved to the bottom left corner of the frame
+
+auto roi_center(const cv::Rect2d& roi, int frame_height) -> std::pair<double, double>;
+
+// ROI moved to an image resized by the given factors
+
+auto scale_roi(const cv::Rect2d& roi, cv::Point2d scale) -> cv::Rect2d;
+
+}  // namespace tracker
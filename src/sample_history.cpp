@@ -0,0 +1,85 @@
+#include "sample_history.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sound {
+
+void SampleHistory::set_capacity(size_t capacity) {
+  if (capacity == max_samples) {
+    return;
+  }
+
+  const auto kept = std::min(n_samples, capacity);
+
+  std::vector<float> new_data(2U * capacity);
+
+  std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(start + n_samples - kept), kept, new_data.begin());
+
+  data = std::move(new_data);
+
+  start = 0;
+  n_samples = kept;
+  max_samples = capacity;
+}
+
+void SampleHistory::append(std::span<const float> values) {
+  n_total += values.size();
+
+  if (max_samples == 0U) {
+    return;
+  }
+
+  if (values.size() >= max_samples) {
+    std::ranges::copy(values.last(max_samples), data.begin());
+
+    start = 0;
+    n_samples = max_samples;
+
+    return;
+  }
+
+  // dropping the oldest samples that will not fit in the window
+
+  if (const auto n_drop = (n_samples + values.size() > max_samples) ? n_samples + values.size() - max_samples : 0U;
+      n_drop > 0U) {
+    start += n_drop;
+    n_samples -= n_drop;
+  }
+
+  if (start + n_samples + values.size() > data.size()) {
+    std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(start), n_samples, data.begin());
+
+    start = 0;
+  }
+
+  std::ranges::copy(values, data.begin() + static_cast<std::ptrdiff_t>(start + n_samples));
+
+  n_samples += values.size();
+}
+
+void SampleHistory::clear() {
+  start = 0;
+  n_samples = 0;
+  n_total = 0;
+}
+
+auto SampleHistory::samples() const -> std::span<const float> {
+  return std::span<const float>(data).subspan(start, n_samples);
+}
+
+auto SampleHistory::size() const -> size_t {
+  return n_samples;
+}
+
+auto SampleHistory::capacity() const -> size_t {
+  return max_samples;
+}
+
+auto SampleHistory::total() const -> uint64_t {
+  return n_total;
+}
+
+}  // namespace sound
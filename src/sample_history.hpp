@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sound {
+
+/*
+  The most recent samples of the audio stream, kept as floats in a buffer with twice the capacity. New samples are
+  appended after the old ones and the window is moved back to the beginning only when the end of the buffer is
+  reached. So the window is always contiguous and the copy happens once every capacity samples.
+*/
+
+class SampleHistory {
+ public:
+  void set_capacity(size_t capacity);
+
+  void append(std::span<const float> values);
+
+  void clear();
+
+  [[nodiscard]] auto samples() const -> std::span<const float>;
+
+  [[nodiscard]] auto size() const -> size_t;
+
+  [[nodiscard]] auto capacity() const -> size_t;
+
+  // samples appended since the last clear. The index of samples()[0] is total() - size()
+
+  [[nodiscard]] auto total() const -> uint64_t;
+
+ private:
+  size_t start = 0;
+  size_t n_samples = 0;
+  size_t max_samples = 0;
+
+  uint64_t n_total = 0;
+
+  std::vector<float> data;
+};
+
+}  // namespace sound
@@ -0,0 +1,62 @@
+#include "sliding_min_max.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+void SlidingMinMax::push(double value) {
+  const auto index = n_pushed++;
+
+  if (std::isnan(value)) {
+    return;
+  }
+
+  while (!min_queue.empty() && min_queue.back().second >= value) {
+    min_queue.pop_back();
+  }
+
+  while (!max_queue.empty() && max_queue.back().second <= value) {
+    max_queue.pop_back();
+  }
+
+  min_queue.emplace_back(index, value);
+  max_queue.emplace_back(index, value);
+}
+
+void SlidingMinMax::keep_last(size_t n_samples) {
+  if (n_pushed <= n_samples) {
+    return;
+  }
+
+  const uint64_t first = n_pushed - n_samples;
+
+  while (!min_queue.empty() && min_queue.front().first < first) {
+    min_queue.pop_front();
+  }
+
+  while (!max_queue.empty() && max_queue.front().first < first) {
+    max_queue.pop_front();
+  }
+}
+
+void SlidingMinMax::clear() {
+  n_pushed = 0;
+
+  min_queue.clear();
+  max_queue.clear();
+}
+
+auto SlidingMinMax::empty() const -> bool {
+  return min_queue.empty();
+}
+
+auto SlidingMinMax::min() const -> double {
+  return min_queue.empty() ? 0.0 : min_queue.front().second;
+}
+
+auto SlidingMinMax::max() const -> double {
+  return max_queue.empty() ? 0.0 : max_queue.front().second;
+}
+
+}  // namespace util
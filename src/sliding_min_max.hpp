@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace util {
+
+/*
+  Minimum and maximum of the most recent samples of a stream. Two monotonic deques are kept. The front of each one is
+  the current extreme and values that can never become an extreme again are discarded as soon as a larger (or
+  smaller) sample arrives. Pushing and evicting are O(1) amortized. NaN samples occupy a position in the stream but
+  are ignored by the extremes.
+*/
+
+class SlidingMinMax {
+ public:
+  void push(double value);
+
+  void keep_last(size_t n_samples);
+
+  void clear();
+
+  [[nodiscard]] auto empty() const -> bool;
+
+  [[nodiscard]] auto min() const -> double;
+
+  [[nodiscard]] auto max() const -> double;
+
+ private:
+  uint64_t n_pushed = 0;
+
+  std::deque<std::pair<uint64_t, double>> min_queue;
+  std::deque<std::pair<uint64_t, double>> max_queue;
+};
+
+}  // namespace util
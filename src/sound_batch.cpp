@@ -0,0 +1,189 @@
+#include "sound_batch.hpp"
+#include <qaudiobuffer.h>
+#include <qaudiodecoder.h>
+#include <qaudioformat.h>
+#include <qeventloop.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qurl.h>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <span>
+#include <string>
+#include <vector>
+#include "fft.hpp"
+#include "table_writer.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+namespace sound {
+
+auto analyze_file(const BatchOptions& options, const std::filesystem::path& file) -> bool {
+  const auto output_base = (options.output_dir.empty() ? file.parent_path() : options.output_dir) / file.stem();
+
+  const auto spectrogram_path = output_base.string() + "_spectrogram.tsv";
+  const auto spectrum_path = output_base.string() + "_spectrum.tsv";
+
+  util::TableWriter spectrogram_file(spectrogram_path, options.precision, util::TableWriter::Notation::scientific, '\t',
+                                     true);
+
+  if (!spectrogram_file.is_open()) {
+    return false;
+  }
+
+  FFTPlanCache fft_plans;
+
+  WelchEstimator welch;
+
+  // Every segment is written to the spectrogram. So the estimator only has to hold the last one.
+
+  welch.configure(options.fft_size, options.hop, 1);
+
+  const auto n_bins = (static_cast<size_t>(welch.fft_size()) / 2U) + 1U;
+
+  std::vector<double> power_sum(n_bins, 0.0);
+  std::vector<float> samples;
+
+  size_t samples_start = 0;
+  size_t n_segments = 0;
+
+  int sampling_rate = 0;
+
+  bool failed = false;
+
+  auto frequency = [&](size_t bin) {
+    return 0.5 * static_cast<double>(sampling_rate) * static_cast<double>(bin) / static_cast<double>(n_bins);
+  };
+
+  QAudioDecoder decoder;
+  QEventLoop loop;
+
+  QAudioFormat format;
+
+  format.setSampleFormat(QAudioFormat::Float);
+  format.setChannelCount(1);
+
+  decoder.setAudioFormat(format);
+  decoder.setSource(QUrl::fromLocalFile(QString::fromStdString(file.string())));
+
+  QObject::connect(&decoder, &QAudioDecoder::bufferReady, [&]() {
+    const auto qaudio_buffer = decoder.read();
+
+    if (sampling_rate == 0) {
+      sampling_rate = qaudio_buffer.format().sampleRate();
+
+      // the DC component at f = 0 Hz is not saved. Same as in the chart.
+
+      spectrogram_file.write("#time");
+
+      for (size_t i = 1U; i < n_bins; i++) {
+        spectrogram_file.add(frequency(i));
+      }
+
+      spectrogram_file.end_row();
+    }
+
+    auto input_data = std::span<const float>(qaudio_buffer.constData<float>(), qaudio_buffer.sampleCount());
+
+    samples.insert(samples.end(), input_data.begin(), input_data.end());
+
+    // Feeding one hop at a time guarantees that each successful push added exactly one segment
+
+    while (samples.size() - samples_start >= static_cast<size_t>(options.hop)) {
+      auto block = std::span<const float>(samples).subspan(samples_start, static_cast<size_t>(options.hop));
+
+      samples_start += block.size();
+
+      if (!welch.push(block, fft_plans, options.measure_plans)) {
+        continue;
+      }
+
+      const auto power = welch.latest_periodogram();
+
+      const double t = static_cast<double>(n_segments * static_cast<size_t>(options.hop)) / sampling_rate;
+
+      spectrogram_file.add(t);
+
+      for (size_t i = 1U; i < n_bins; i++) {
+        spectrogram_file.add(power[i]);
+
+        power_sum[i] += power[i];
+      }
+
+      spectrogram_file.end_row();
+
+      n_segments++;
+    }
+
+    samples.erase(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(samples_start));
+
+    samples_start = 0;
+  });
+
+  QObject::connect(&decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), [&](QAudioDecoder::Error) {
+    util::warning(file.string() + ": " + decoder.errorString().toStdString());
+
+    failed = true;
+
+    loop.quit();
+  });
+
+  QObject::connect(&decoder, &QAudioDecoder::finished, &loop, &QEventLoop::quit);
+
+  decoder.start();
+
+  if (!failed) {
+    loop.exec();
+  }
+
+  decoder.stop();
+
+  spectrogram_file.close();
+
+  if (failed) {
+    return false;
+  }
+
+  if (n_segments == 0U) {
+    util::warning(std::format("{}: shorter than one segment of {} samples", file.string(), welch.fft_size()));
+
+    return false;
+  }
+
+  util::TableWriter spectrum_file(spectrum_path, options.precision, util::TableWriter::Notation::scientific);
+
+  spectrum_file.write("#frequency\tvalue\n");
+
+  for (size_t i = 1U; i < n_bins; i++) {
+    spectrum_file.add(frequency(i));
+    spectrum_file.add(power_sum[i] / static_cast<double>(n_segments));
+    spectrum_file.end_row();
+  }
+
+  spectrum_file.close();
+
+  util::info(std::format("{}: {} segments analyzed, tables saved to {}", file.string(), n_segments,
+                         output_base.parent_path().string()));
+
+  return true;
+}
+
+auto analyze_files(const BatchOptions& options) -> int {
+  std::atomic<int> n_failures = 0;
+
+  util::ThreadPool pool(options.jobs - 1);
+
+  // Each job runs its own event loop for the decoder signals. They are delivered in the thread of the job.
+
+  pool.parallel_for(options.files.size(), [&](size_t n) {
+    if (!analyze_file(options, options.files[n])) {
+      n_failures++;
+    }
+  });
+
+  return n_failures;
+}
+
+}  // namespace sound
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+namespace sound {
+
+struct BatchOptions {
+  int jobs = 1;  // files processed at the same time
+
+  int precision = 6;
+
+  int fft_size = 4096;
+
+  int hop = 2048;  // samples between the start of consecutive segments
+
+  bool measure_plans = false;
+
+  std::filesystem::path output_dir;  // when empty the tables are written next to the audio file
+
+  std::vector<std::filesystem::path> files;
+};
+
+/*
+  Decodes each file at full speed and splits it in Hann windowed segments of fft_size samples. For every file two
+  tables are written. <file>_spectrogram.tsv has one row per segment and one column per frequency. <file>_spectrum.tsv
+  has the Welch average of all segments. Returns the number of files that could not be processed.
+*/
+
+auto analyze_files(const BatchOptions& options) -> int;
+
+}  // namespace sound
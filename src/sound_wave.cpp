@@ -1,5 +1,4 @@
 #include "sound_wave.hpp"
-#include <fftw3.h>
 #include <qabstractseries.h>
 #include <qaudiodecoder.h>
 #include <qaudioformat.h>
@@ -12,42 +11,47 @@
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qxyseries.h>
+#include <QDateTime>
 #include <QMediaDevices>
+#include <QStandardPaths>
+#include <QTimer>
 #include <algorithm>
-#include <chrono>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
-#include <format>
-#include <fstream>
+#include <filesystem>
+#include <limits>
 #include <memory>
 #include <mutex>
-#include <numbers>
-#include <ratio>
-#include <regex>
+#include <string>
 #include <span>
 #include <thread>
 #include <vector>
 #include "config.h"
 #include "eyeofsauron_db.h"
+#include "fft.hpp"
 #include "frame_source.hpp"
 #include "io_device.hpp"
+#include "min_max_envelope.hpp"
+#include "sample_history.hpp"
+#include "sliding_min_max.hpp"
+#include "table_writer.hpp"
 #include "util.hpp"
+#include "wav_writer.hpp"
 
 namespace sound {
 
 Backend::Backend(QObject* parent)
-    : QObject(parent), io_device(std::make_unique<IODevice>()), decoder(std::make_unique<QAudioDecoder>()) {
+    : QObject(parent),
+      io_device(std::make_unique<IODevice>()),
+      decoder(std::make_unique<QAudioDecoder>()),
+      playback_timer(std::make_unique<QTimer>()),
+      chart_timer(std::make_unique<QTimer>()) {
   qmlRegisterSingletonInstance<Backend>("EoSSoundBackend", VERSION_MAJOR, VERSION_MINOR, "EoSSoundBackend", this);
 
   qmlRegisterSingletonInstance<SourceModel>("EosSoundSourceModel", VERSION_MAJOR, VERSION_MINOR, "EosSoundSourceModel",
                                             &sourceModel);
 
-  connect(io_device.get(), &IODevice::bufferChanged, [this](const std::vector<double>& buffer) {
-    std::lock_guard<std::mutex> microphone_lock_guard(microphone_mutex);
-
-    process_buffer(buffer, microphone->format().sampleRate());
-  });
-
   connect(decoder.get(), &QAudioDecoder::positionChanged, [this](const qint64& value) {
     _playerPosition = value;
 
@@ -63,35 +67,46 @@ Backend::Backend(QObject* parent)
   });
 
   connect(decoder.get(), &QAudioDecoder::bufferReady, [this]() {
-    auto qaudio_buffer = decoder->read();
-
-    if (decoder_buffer.size() != static_cast<size_t>(qaudio_buffer.sampleCount())) {
-      decoder_buffer.resize(qaudio_buffer.sampleCount());
+    switch (db::Main::mediaFilePacing()) {
+      case db::Main::EnumMediaFilePacing::realtime: {
+        pace_decoder();
+        break;
+      }
+      case db::Main::EnumMediaFilePacing::fast: {
+        while (decoder->bufferAvailable()) {
+          process_decoded_buffer(decoder->read());
+        }
+        break;
+      }
+      default:
+        break;
     }
+  });
 
-    auto input_data = std::span<const float>(qaudio_buffer.constData<float>(), qaudio_buffer.sampleCount());
+  // The decoder does not decode ahead of the buffers we did not read yet. So leaving them in the decoder until their
+  // time comes keeps the memory bounded without a queue of our own.
 
-    std::copy(input_data.begin(), input_data.end(), decoder_buffer.begin());
+  playback_timer->setTimerType(Qt::PreciseTimer);
 
-    if (qaudio_buffer.startTime() == 0) {
-      first_buffer_clock = std::chrono::steady_clock::now();
-    }
+  connect(playback_timer.get(), &QTimer::timeout, [this]() { pace_decoder(); });
 
-    std::chrono::duration<double, std::micro> diff = std::chrono::steady_clock::now() - first_buffer_clock;
+  // The buffers only mark the charts as outdated. They are redrawn at the display rate whatever the buffer rate is.
 
-    auto elapsed_time = diff.count();
+  connect(chart_timer.get(), &QTimer::timeout, [this]() { refresh_chart(); });
 
-    while (static_cast<qint64>(elapsed_time) < qaudio_buffer.startTime()) {
-      std::this_thread::sleep_for(std::chrono::microseconds(1));
+  connect(db::Main::self(), &db::Main::chartRefreshRateChanged,
+          [this]() { chart_timer->setInterval(1000 / db::Main::chartRefreshRate()); });
 
-      std::chrono::duration<double, std::micro> diff = std::chrono::steady_clock::now() - first_buffer_clock;
+  chart_timer->start(1000 / db::Main::chartRefreshRate());
 
-      elapsed_time = diff.count();
-    }
+  connect(db::Main::self(), &db::Main::recordAudioChanged, [this]() {
+    std::lock_guard<std::mutex> data_lock_guard(data_mutex);
 
-    // qDebug() << static_cast<qint64>(elapsed_time) << qaudio_buffer.startTime();
+    recording_failed = false;
 
-    process_buffer(decoder_buffer, qaudio_buffer.format().sampleRate());
+    if (!db::Main::recordAudio()) {
+      close_recording();
+    }
   });
 
   io_device->open(QIODevice::WriteOnly);
@@ -104,6 +119,8 @@ Backend::Backend(QObject* parent)
   decoder->setAudioFormat(format);
 
   find_microphones();
+
+  analysis_thread = std::thread([this]() { analyze_microphone(); });
 }
 
 Backend::~Backend() {
@@ -111,9 +128,23 @@ Backend::~Backend() {
     microphone->stop();
   }
 
+  playback_timer->stop();
+
   decoder->stop();
 
   exiting = true;
+
+  {
+    std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+    close_recording();
+  }
+
+  analysis_running = false;
+
+  io_device->ring.wake();
+
+  analysis_thread.join();
 }
 
 void Backend::start() {
@@ -122,7 +153,16 @@ void Backend::start() {
       break;
     }
     case MediaFile: {
+      pending_buffer = QAudioBuffer();
+
+      playback_clock.invalidate();
+
       decoder->start();
+
+      if (db::Main::mediaFilePacing() == db::Main::EnumMediaFilePacing::realtime) {
+        playback_timer->start(playback_interval_ms);
+      }
+
       break;
     }
     case Microphone: {
@@ -140,6 +180,8 @@ void Backend::pause() {
       break;
     }
     case MediaFile: {
+      playback_timer->stop();
+
       decoder->stop();
       break;
     }
@@ -153,16 +195,23 @@ void Backend::pause() {
 }
 
 void Backend::stop() {
-  time_axis = 0;
+  {
+    std::lock_guard<std::mutex> data_lock_guard(data_mutex);
 
-  waveform.clear();
-  fft_list.clear();
+    clear_data();
+
+    close_recording();
+  }
+
+  discard_microphone_samples = true;
 
   switch (current_source_type) {
     case Camera: {
       break;
     }
     case MediaFile: {
+      playback_timer->stop();
+
       decoder->stop();
       break;
     }
@@ -188,8 +237,20 @@ void Backend::selectSource(const int& index) {
     microphone->stop();
   }
 
+  playback_timer->stop();
+
   decoder->stop();
 
+  {
+    // the next source may have another sampling rate
+
+    std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+    clear_data();
+
+    close_recording();
+  }
+
   switch (source->source_type) {
     case Camera: {
       break;
@@ -216,7 +277,9 @@ void Backend::selectSource(const int& index) {
 
       io_device->set_format(format);
 
-      std::lock_guard<std::mutex> microphone_lock_guard(microphone_mutex);
+      microphone_sampling_rate = format.sampleRate();
+
+      discard_microphone_samples = true;
 
       microphone = std::make_unique<QAudioSource>(device, format);
 
@@ -227,6 +290,44 @@ void Backend::selectSource(const int& index) {
   Q_EMIT showPlayerSliderChanged();
 }
 
+void Backend::pace_decoder() {
+  while (true) {
+    if (!pending_buffer.isValid()) {
+      if (!decoder->bufferAvailable()) {
+        return;
+      }
+
+      pending_buffer = decoder->read();
+    }
+
+    // the clock starts with the first buffer so the decoder startup latency does not count
+
+    if (!playback_clock.isValid()) {
+      playback_clock.start();
+
+      playback_offset = pending_buffer.startTime();
+    }
+
+    const auto elapsed_us = (playback_clock.nsecsElapsed() / 1000) + playback_offset;
+
+    if (pending_buffer.startTime() > elapsed_us) {
+      return;
+    }
+
+    process_decoded_buffer(pending_buffer);
+
+    pending_buffer = QAudioBuffer();
+  }
+}
+
+void Backend::process_decoded_buffer(const QAudioBuffer& qaudio_buffer) {
+  auto input_data = std::span<const float>(qaudio_buffer.constData<float>(), qaudio_buffer.sampleCount());
+
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+  process_buffer(input_data, qaudio_buffer.format().sampleRate());
+}
+
 void Backend::find_microphones() {
   for (const auto& device : QMediaDevices::audioInputs()) {
     if (!device.isNull()) {
@@ -235,95 +336,312 @@ void Backend::find_microphones() {
   }
 }
 
-void Backend::calc_fft(const int& sampling_rate) {
-  if (waveform.empty()) {
+void Backend::analyze_microphone() {
+  analysis_samples.resize(analysis_chunk_size);
+
+  auto& ring = io_device->ring;
+
+  while (analysis_running) {
+    ring.wait();
+
+    if (discard_microphone_samples.exchange(false)) {
+      ring.discard();
+    }
+
+    while (analysis_running) {
+      const auto n_samples = ring.read(analysis_samples);
+
+      if (n_samples == 0U) {
+        break;
+      }
+
+      std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+      process_buffer(std::span<const float>(analysis_samples).first(n_samples), microphone_sampling_rate);
+    }
+  }
+}
+
+void Backend::refresh_chart() {
+  // Called by the chart timer at the display rate. However many buffers arrived since the last call they are drawn
+  // once, and only the charts that got new data are touched.
+
+  update_overrun_counters();
+
+  const bool waveform_changed = waveform_dirty.exchange(false);
+  const bool spectrum_changed = spectrum_dirty.exchange(false);
+
+  if (!waveform_changed && !spectrum_changed) {
     return;
   }
 
-  fft_list.resize((waveform.size() / 2U) + 1U);
+  {
+    std::lock_guard<std::mutex> data_lock_guard(data_mutex);
 
-  real_input.resize(0);
+    if (waveform_changed) {
+      update_waveform_chart_range();
+    }
+
+    if (spectrum_changed) {
+      update_fft_chart_range();
+    }
+  }
+
+  Q_EMIT updateChart(waveform_changed, spectrum_changed);
+}
+
+void Backend::update_overrun_counters() {
+  if (auto samples = io_device->overrun_samples.load(); samples != _overrunSamples) {
+    _overrunSamples = samples;
+
+    Q_EMIT overrunSamplesChanged();
+  }
+
+  if (auto events = io_device->overrun_events.load(); events != _overrunEvents) {
+    _overrunEvents = events;
+
+    Q_EMIT overrunEventsChanged();
+  }
+}
 
-  for (const auto& p : waveform) {
-    real_input.emplace_back(p.y());
+void Backend::calc_fft(const int& sampling_rate) {
+  if (history.size() == 0U) {
+    return;
   }
 
-  for (uint n = 0U; n < real_input.size(); n++) {
-    // https://en.wikipedia.org/wiki/Hann_function
+  const auto samples = history.samples();
 
-    const float w = 0.5F * (1.0F - std::cos(2.0F * std::numbers::pi_v<float> * static_cast<float>(n) /
-                                            static_cast<float>(real_input.size() - 1U)));
+  auto& fft = fft_plans.get(static_cast<int>(samples.size()), db::Main::fftMeasurePlans());
 
-    real_input[n] *= w;
+  auto input = fft.input();
+  auto window = fft.window();
+
+  for (size_t n = 0U; n < input.size(); n++) {
+    input[n] = samples[n] * window[n];
   }
 
-  auto* complex_output = fftw_alloc_complex(real_input.size());
+  fft.execute();
+
+  auto complex_output = fft.output();
 
-  auto* plan =
-      fftw_plan_dft_r2c_1d(static_cast<int>(real_input.size()), real_input.data(), complex_output, FFTW_ESTIMATE);
+  const auto n_bins = complex_output.size();
 
-  fftw_execute(plan);
+  window_power.resize(n_bins);
 
-  for (uint i = 0U; i < fft_list.size(); i++) {
+  for (size_t i = 0U; i < n_bins; i++) {
     double sqr = (complex_output[i][0] * complex_output[i][0]) + (complex_output[i][1] * complex_output[i][1]);
 
-    sqr /= static_cast<double>(fft_list.size() * fft_list.size());
+    window_power[i] = sqr / static_cast<double>(n_bins * n_bins);
+  }
+
+  set_spectrum(window_power, sampling_rate);
+}
+
+void Backend::calc_welch_fft(std::span<const float> buffer, const int& sampling_rate) {
+  const auto fft_size = db::Main::fftSize();
+
+  const auto hop = static_cast<int>(std::lround(fft_size * (1.0 - db::Main::fftOverlap())));
+
+  welch.configure(fft_size, hop, db::Main::welchSegments());
+
+  if (welch.push(buffer, fft_plans, db::Main::fftMeasurePlans())) {
+    set_spectrum(welch.spectrum(), sampling_rate);
+  }
+}
 
-    double f = 0.5F * static_cast<float>(sampling_rate) * static_cast<float>(i) / static_cast<float>(fft_list.size());
+void Backend::set_spectrum(std::span<const double> power, const int& sampling_rate) {
+  const auto n_bins = power.size();
 
-    fft_list[i] = QPointF(f, sqr);
+  if (n_bins < 2U) {
+    return;
   }
 
-  // removing the DC component at f = 0 Hz
+  // the DC component at f = 0 Hz is not shown
+
+  fft_list.resize(static_cast<qsizetype>(n_bins - 1U));
 
-  fft_list.erase(fft_list.begin());
+  fft_min = std::numeric_limits<double>::max();
+  fft_max = std::numeric_limits<double>::lowest();
 
-  if (complex_output != nullptr) {
-    fftw_free(complex_output);
+  for (size_t i = 1U; i < n_bins; i++) {
+    double f = 0.5F * static_cast<float>(sampling_rate) * static_cast<float>(i) / static_cast<float>(n_bins);
+
+    fft_list[static_cast<qsizetype>(i - 1U)] = QPointF(f, power[i]);
+
+    fft_min = std::min(fft_min, power[i]);
+    fft_max = std::max(fft_max, power[i]);
   }
 
-  fftw_destroy_plan(plan);
+  spectrum_dirty = true;
 }
 
-void Backend::process_buffer(const std::vector<double>& buffer, const int& sampling_rate) {
-  double dt = 1.0 / sampling_rate;
+void Backend::process_buffer(std::span<const float> buffer, const int& sampling_rate) {
+  if (db::Main::recordAudio() && open_recording(sampling_rate)) {
+    recorder.append(buffer);
+  }
 
-  for (double v : buffer) {
-    waveform.append(QPointF(time_axis, v));
+  waveform_rate = sampling_rate;
 
-    time_axis += dt;
+  // The raw samples of the time window are kept for the fft. The chart only gets their min/max envelope.
+
+  history.set_capacity(static_cast<size_t>(db::Main::chartTimeWindow() * sampling_rate) + 1U);
+
+  if (envelope.configure(history.capacity(), static_cast<size_t>(chart_columns))) {
+    rebuild_envelope();
   }
 
-  while ((waveform.size() - 1) * dt > db::Main::chartTimeWindow()) {
-    waveform.removeFirst();
-    waveform.removeFirst();
+  const double dt = 1.0 / sampling_rate;
+
+  auto index = history.total();
+
+  history.append(buffer);
+
+  for (float v : buffer) {
+    envelope.push(static_cast<double>(index++) * dt, v);
+
+    waveform_range.push(v);
   }
 
-  calc_fft(sampling_rate);
+  waveform_range.keep_last(history.size());
 
-  update_waveform_chart_range();
-  update_fft_chart_range();
+  switch (db::Main::spectrumMethod()) {
+    case db::Main::EnumSpectrumMethod::window: {
+      calc_fft(sampling_rate);
+      break;
+    }
+    case db::Main::EnumSpectrumMethod::welch: {
+      calc_welch_fft(buffer, sampling_rate);
+      break;
+    }
+    default:
+      break;
+  }
 
-  Q_EMIT updateChart();
+  waveform_dirty = true;
+}
+
+void Backend::rebuild_envelope() {
+  envelope.clear();
+
+  const auto samples = history.samples();
+
+  auto index = history.total() - samples.size();
+
+  for (float v : samples) {
+    envelope.push(static_cast<double>(index++) / waveform_rate, v);
+  }
+}
+
+void Backend::clear_data() {
+  history.clear();
+  envelope.clear();
+
+  fft_list.clear();
+
+  waveform_range.clear();
+
+  welch.reset();
+}
+
+auto Backend::open_recording(int sampling_rate) -> bool {
+  if (recorder.is_open() && sampling_rate == recording_rate) {
+    return true;
+  }
+
+  close_recording();
+
+  if (recording_failed) {
+    return false;
+  }
+
+  const auto file_name =
+      QDateTime::currentDateTime().toString(QStringLiteral("'sound_'yyyyMMdd_hhmmss'.wav'")).toStdString();
+
+  const auto documents = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation).toStdString();
+
+  const auto path = std::filesystem::path(documents) / file_name;
+
+  if (!recorder.open(path, sampling_rate)) {
+    recording_failed = true;
+
+    return false;
+  }
+
+  recording_rate = sampling_rate;
+
+  util::info("Recording the audio to: " + path.string());
+
+  return true;
+}
+
+void Backend::close_recording() {
+  if (!recorder.is_open()) {
+    return;
+  }
+
+  recorder.close();
+
+  util::info("Audio recording saved to: " + recorder.path().string());
+}
+
+void Backend::setWaveformChartWidth(int width) {
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+  chart_columns = std::max(width, 1);
+
+  if (envelope.configure(history.capacity(), static_cast<size_t>(chart_columns))) {
+    rebuild_envelope();
+  }
+
+  waveform_dirty = true;
+}
+
+void Backend::setSpectrumChartWidth(int width) {
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+  fft_chart_columns = std::max(width, 1);
+
+  spectrum_dirty = true;
 }
 
 void Backend::update_waveform_chart_range() {
-  if (waveform.empty()) {
+  if (history.size() == 0U) {
     return;
   }
 
-  auto [min_x, max_x] = std::ranges::minmax_element(waveform, [](QPointF a, QPointF b) { return a.x() < b.x(); });
-  auto [min_y, max_y] = std::ranges::minmax_element(waveform, [](QPointF a, QPointF b) { return a.y() < b.y(); });
+  // The time axis grows monotonically and the amplitude extremes are kept by the sliding window. No need to rescan
+  // the whole waveform.
+
+  const double x_min = static_cast<double>(history.total() - history.size()) / waveform_rate;
+  const double x_max = static_cast<double>(history.total() - 1U) / waveform_rate;
+  const double y_min = waveform_range.min();
+  const double y_max = waveform_range.max();
+
+  // qml relayouts the chart on every notification. Only the values that moved are announced
+
+  if (x_min != _xAxisMinWave) {
+    _xAxisMinWave = x_min;
+
+    Q_EMIT xAxisMinWaveChanged();
+  }
+
+  if (x_max != _xAxisMaxWave) {
+    _xAxisMaxWave = x_max;
+
+    Q_EMIT xAxisMaxWaveChanged();
+  }
+
+  if (y_min != _yAxisMinWave) {
+    _yAxisMinWave = y_min;
+
+    Q_EMIT yAxisMinWaveChanged();
+  }
 
-  _xAxisMinWave = min_x->x();
-  _xAxisMaxWave = max_x->x();
-  _yAxisMinWave = min_y->y();
-  _yAxisMaxWave = max_y->y();
+  if (y_max != _yAxisMaxWave) {
+    _yAxisMaxWave = y_max;
 
-  Q_EMIT xAxisMinWaveChanged();
-  Q_EMIT xAxisMaxWaveChanged();
-  Q_EMIT yAxisMinWaveChanged();
-  Q_EMIT yAxisMaxWaveChanged();
+    Q_EMIT yAxisMaxWaveChanged();
+  }
 }
 
 void Backend::update_fft_chart_range() {
@@ -331,36 +649,58 @@ void Backend::update_fft_chart_range() {
     return;
   }
 
-  auto [min_x, max_x] = std::ranges::minmax_element(fft_list, [](QPointF a, QPointF b) { return a.x() < b.x(); });
-  auto [min_y, max_y] = std::ranges::minmax_element(fft_list, [](QPointF a, QPointF b) { return a.y() < b.y(); });
+  // the power extremes were found while calc_fft filled the spectrum
+
+  const double x_min = fft_list.front().x();
+  const double x_max = fft_list.back().x();
+
+  if (x_min != _xAxisMinFFT) {
+    _xAxisMinFFT = x_min;
+
+    Q_EMIT xAxisMinFFTChanged();
+  }
+
+  if (x_max != _xAxisMaxFFT) {
+    _xAxisMaxFFT = x_max;
 
-  _xAxisMinFFT = min_x->x();
-  _xAxisMaxFFT = max_x->x();
-  _yAxisMinFFT = min_y->y();
-  _yAxisMaxFFT = max_y->y();
+    Q_EMIT xAxisMaxFFTChanged();
+  }
+
+  if (fft_min != _yAxisMinFFT) {
+    _yAxisMinFFT = fft_min;
+
+    Q_EMIT yAxisMinFFTChanged();
+  }
+
+  if (fft_max != _yAxisMaxFFT) {
+    _yAxisMaxFFT = fft_max;
 
-  Q_EMIT xAxisMinFFTChanged();
-  Q_EMIT xAxisMaxFFTChanged();
-  Q_EMIT yAxisMinFFTChanged();
-  Q_EMIT yAxisMaxFFTChanged();
+    Q_EMIT yAxisMaxFFTChanged();
+  }
 }
 
 void Backend::updateSeriesWaveform(QAbstractSeries* series) {
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
   if (series != nullptr) {
     auto xySeries = dynamic_cast<QXYSeries*>(series);
 
-    if (waveform.empty()) {
+    if (history.size() == 0U) {
       return;
     }
 
+    envelope.fill(waveform_points);
+
     // Use replace instead of clear + append, it's optimized for performance
-    xySeries->replace(waveform);
+    xySeries->replace(waveform_points);
   } else {
     util::warning("series waveform is null!");
   }
 }
 
 void Backend::updateSeriesFFT(QAbstractSeries* series) {
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
   if (series != nullptr) {
     auto xySeries = dynamic_cast<QXYSeries*>(series);
 
@@ -368,49 +708,64 @@ void Backend::updateSeriesFFT(QAbstractSeries* series) {
       return;
     }
 
+    // The frequency axis is logarithmic. The columns are uniform in log(f) so that the high frequencies, where most
+    // of the bins are, do not flood the chart with points that land in the same pixel.
+
+    util::MinMaxEnvelope::decimate(fft_list, static_cast<size_t>(fft_chart_columns), true, fft_points);
+
     // Use replace instead of clear + append, it's optimized for performance
-    xySeries->replace(fft_list);
+    xySeries->replace(fft_points);
   } else {
     util::warning("series fft is null!");
   }
 }
 
 void Backend::saveTable(const QUrl& fileUrl) {
-  if (waveform.empty() || fft_list.empty()) {
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+  if (history.size() == 0U || fft_list.empty()) {
     return;
   }
 
   if (fileUrl.isLocalFile()) {
-    {  // waveform
-      std::ofstream output_file(
-          std::regex_replace(fileUrl.toLocalFile().toStdString(), std::regex(".tsv"), "_waveform.tsv"));
+    // the chosen name without its extension is the base of the two table names
 
-      output_file << "#time\tvalue\n";
+    auto base = std::filesystem::path(fileUrl.toLocalFile().toStdString()).replace_extension();
 
-      for (const auto& p : waveform) {
-        output_file << std::format("{1:.{0}e}\t{2:.{0}e}", db::Main::tableFilePrecision(), p.x(), p.y()) << "\n";
-      }
+    {  // waveform at full resolution
+      util::TableWriter table(base.string() + "_waveform.tsv", db::Main::tableFilePrecision(),
+                              util::TableWriter::Notation::scientific, '\t', true);
+
+      table.write("#time\tvalue\n");
+
+      auto index = history.total() - history.size();
 
-      output_file.close();
+      for (float v : history.samples()) {
+        table.add(static_cast<double>(index++) / waveform_rate);
+        table.add(static_cast<double>(v));
+        table.end_row();
+      }
     }
 
     {  // fft
-      std::ofstream output_file(
-          std::regex_replace(fileUrl.toLocalFile().toStdString(), std::regex(".tsv"), "_fft.tsv"));
+      util::TableWriter table(base.string() + "_fft.tsv", db::Main::tableFilePrecision(),
+                              util::TableWriter::Notation::scientific, '\t', true);
 
-      output_file << "#frequency\tvalue\n";
+      table.write("#frequency\tvalue\n");
 
       for (const auto& p : fft_list) {
-        output_file << std::format("{1:.{0}e}\t{2:.{0}e}", db::Main::tableFilePrecision(), p.x(), p.y()) << "\n";
+        table.add(p.x());
+        table.add(p.y());
+        table.end_row();
       }
-
-      output_file.close();
     }
   }
 }
 
 void Backend::setPlayerPosition(qint64 value) {
-  time_axis = 0;
+  std::lock_guard<std::mutex> data_lock_guard(data_mutex);
+
+  clear_data();
 
   // decoder->setPosition(value);
 }
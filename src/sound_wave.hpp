@@ -11,15 +11,26 @@
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
+#include <QAudioBuffer>
 #include <QAudioDecoder>
 #include <QAudioOutput>
 #include <QAudioSource>
-#include <chrono>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <mutex>
+#include <span>
+#include <thread>
 #include <vector>
+#include "fft.hpp"
 #include "frame_source.hpp"
 #include "io_device.hpp"
+#include "min_max_envelope.hpp"
+#include "sample_history.hpp"
+#include "sliding_min_max.hpp"
+#include "wav_writer.hpp"
 
 namespace sound {
 
@@ -48,6 +59,10 @@ class Backend : public QObject {
 
   Q_PROPERTY(double yAxisMaxFFT MEMBER _yAxisMaxFFT NOTIFY yAxisMaxFFTChanged)
 
+  Q_PROPERTY(qint64 overrunSamples MEMBER _overrunSamples NOTIFY overrunSamplesChanged)
+
+  Q_PROPERTY(qint64 overrunEvents MEMBER _overrunEvents NOTIFY overrunEventsChanged)
+
  public:
   Backend(QObject* parent = nullptr);
 
@@ -62,6 +77,8 @@ class Backend : public QObject {
   Q_INVOKABLE void updateSeriesFFT(QAbstractSeries* series);
   Q_INVOKABLE void saveTable(const QUrl& fileUrl);
   Q_INVOKABLE void setPlayerPosition(qint64 value);
+  Q_INVOKABLE void setWaveformChartWidth(int width);
+  Q_INVOKABLE void setSpectrumChartWidth(int width);
 
  signals:
   void xAxisMinWaveChanged();
@@ -75,11 +92,14 @@ class Backend : public QObject {
   void playerPositionChanged();
   void playerDurationChanged();
   void showPlayerSliderChanged();
-  void updateChart();
+  void overrunSamplesChanged();
+  void overrunEventsChanged();
+  void updateChart(bool waveformChanged, bool spectrumChanged);
 
  private:
   bool _showPlayerSlider = false;
   bool exiting = false;
+  bool recording_failed = false;  // avoids trying to create the recording again on every buffer
 
   double _xAxisMinWave = 10000;
   double _xAxisMaxWave = 0;
@@ -89,10 +109,13 @@ class Backend : public QObject {
   double _xAxisMaxFFT = 0;
   double _yAxisMinFFT = 10000;
   double _yAxisMaxFFT = 0;
-  double time_axis = 0;
+  double fft_min = 0;
+  double fft_max = 0;
 
   qint64 _playerPosition = 0;
   qint64 _playerDuration = 0;
+  qint64 _overrunSamples = 0;
+  qint64 _overrunEvents = 0;
 
   SourceModel sourceModel;
 
@@ -101,20 +124,69 @@ class Backend : public QObject {
   std::unique_ptr<IODevice> io_device;
   std::unique_ptr<QAudioSource> microphone;
   std::unique_ptr<QAudioDecoder> decoder;
+  std::unique_ptr<QTimer> playback_timer;
+  std::unique_ptr<QTimer> chart_timer;
+
+  std::mutex data_mutex;  // waveform and spectrum are filled by the analysis thread and read by the gui
+
+  std::atomic<bool> analysis_running = true;
+  std::atomic<bool> discard_microphone_samples = false;
+  std::atomic<bool> waveform_dirty = false;  // set when new samples arrive, cleared by the chart timer
+  std::atomic<bool> spectrum_dirty = false;
+
+  std::atomic<int> microphone_sampling_rate = 0;
 
-  std::mutex microphone_mutex;
+  static constexpr size_t analysis_chunk_size = 4096;
 
-  QList<QPointF> waveform;
+  std::vector<float> analysis_samples;
+
+  std::thread analysis_thread;
+
+  QList<QPointF> waveform_points;  // envelope handed to the chart
   QList<QPointF> fft_list;
+  QList<QPointF> fft_points;  // decimated spectrum handed to the chart
+
+  util::SlidingMinMax waveform_range;
+
+  util::MinMaxEnvelope envelope;
+
+  SampleHistory history;
+
+  WavWriter recorder;
+
+  int waveform_rate = 1;
+  int recording_rate = 0;
+  int chart_columns = 800;  // plot area width in pixels
+  int fft_chart_columns = 800;
+
+  FFTPlanCache fft_plans;
+
+  WelchEstimator welch;
+
+  std::vector<double> window_power;
+
+  static constexpr int playback_interval_ms = 5;
+
+  qint64 playback_offset = 0;  // start time in microseconds of the first buffer played since start()
 
-  std::vector<double> real_input;
-  std::vector<double> decoder_buffer;
+  QAudioBuffer pending_buffer;  // decoded buffer waiting for its time to be played
 
-  std::chrono::time_point<std::chrono::steady_clock> first_buffer_clock;
+  QElapsedTimer playback_clock;
 
   void find_microphones();
-  void process_buffer(const std::vector<double>& buffer, const int& sampling_rate);
+  void analyze_microphone();
+  void refresh_chart();
+  void update_overrun_counters();
+  void pace_decoder();
+  void process_decoded_buffer(const QAudioBuffer& qaudio_buffer);
+  void process_buffer(std::span<const float> buffer, const int& sampling_rate);
   void calc_fft(const int& sampling_rate);
+  void calc_welch_fft(std::span<const float> buffer, const int& sampling_rate);
+  void rebuild_envelope();
+  void clear_data();
+  auto open_recording(int sampling_rate) -> bool;
+  void close_recording();
+  void set_spectrum(std::span<const double> power, const int& sampling_rate);
   void update_waveform_chart_range();
   void update_fft_chart_range();
 };
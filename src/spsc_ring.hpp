@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace util {
+
+/*
+  Lock-free ring buffer for exactly one producer thread and one consumer thread. The storage is allocated once in the
+  constructor. write() and read() only touch two atomic indices, so the producer can be a realtime audio callback.
+  Values that do not fit are dropped by write() and reported through its return value.
+*/
+
+template <typename T>
+class SpscRing {
+ public:
+  explicit SpscRing(size_t min_capacity) : data(std::bit_ceil(std::max<size_t>(min_capacity, 2U))) {
+    mask = data.size() - 1U;
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  auto operator=(const SpscRing&) -> SpscRing& = delete;
+
+  [[nodiscard]] auto capacity() const -> size_t { return data.size(); }
+
+  [[nodiscard]] auto available() const -> size_t {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  // producer side. Returns how many values were stored
+
+  auto write(std::span<const T> values) -> size_t {
+    const auto h = head.load(std::memory_order_relaxed);
+    const auto t = tail.load(std::memory_order_acquire);
+
+    const auto n = std::min(values.size(), data.size() - (h - t));
+
+    const auto first = std::min(n, data.size() - (h & mask));
+
+    std::copy_n(values.begin(), first, data.begin() + static_cast<std::ptrdiff_t>(h & mask));
+    std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(first), n - first, data.begin());
+
+    head.store(h + n, std::memory_order_release);
+
+    wake();
+
+    return n;
+  }
+
+  // consumer side. Returns how many values were copied to the output
+
+  auto read(std::span<T> values) -> size_t {
+    const auto t = tail.load(std::memory_order_relaxed);
+    const auto h = head.load(std::memory_order_acquire);
+
+    const auto n = std::min(values.size(), h - t);
+
+    const auto first = std::min(n, data.size() - (t & mask));
+
+    std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(t & mask), first, values.begin());
+    std::copy_n(data.begin(), n - first, values.begin() + static_cast<std::ptrdiff_t>(first));
+
+    tail.store(t + n, std::memory_order_release);
+
+    return n;
+  }
+
+  // consumer side. Drops everything written so far
+
+  void discard() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+  // Consumer side. Blocks until wake() was called after the previous wait() returned. The futex behind atomic wait
+  // keeps wake() free of locks when nobody is waiting.
+
+  void wait() {
+    wake_count.wait(seen_wake_count, std::memory_order_acquire);
+
+    seen_wake_count = wake_count.load(std::memory_order_acquire);
+  }
+
+  void wake() {
+    wake_count.fetch_add(1U, std::memory_order_release);
+
+    wake_count.notify_one();
+  }
+
+ private:
+  std::vector<T> data;
+
+  size_t mask = 0;
+
+  uint32_t seen_wake_count = 0;  // only used by the consumer
+
+  alignas(64) std::atomic<size_t> head = 0;  // written by the producer
+
+  alignas(64) std::atomic<size_t> tail = 0;  // written by the consumer
+
+  alignas(64) std::atomic<uint32_t> wake_count = 0;
+};
+
+}  // namespace util
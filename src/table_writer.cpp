@@ -0,0 +1,203 @@
+#include "table_writer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <filesystem>
+#include <ios>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include "util.hpp"
+
+namespace util {
+
+constexpr size_t table_block_size = 1024UL * 1024UL;
+
+constexpr size_t max_number_chars = 512;  // enough for any double in fixed notation with a sane precision
+
+TableWriter::TableWriter(const std::filesystem::path& path,
+                         int precision,
+                         Notation notation,
+                         char separator,
+                         bool background)
+    : background(background),
+      separator(separator),
+      precision(precision),
+      notation(notation),
+      file(path, std::ios::binary | std::ios::trunc),
+      buffer(table_block_size + max_number_chars) {
+  if (!file.is_open()) {
+    util::warning("Could not create the table: " + path.string());
+
+    return;
+  }
+
+  if (background) {
+    pending.resize(buffer.size());
+
+    writer = std::thread([this]() { write_blocks(); });
+  }
+}
+
+TableWriter::~TableWriter() {
+  close();
+}
+
+auto TableWriter::is_open() const -> bool {
+  return file.is_open();
+}
+
+void TableWriter::write(std::string_view text) {
+  if (text.empty()) {
+    return;
+  }
+
+  row_start = text.back() == '\n';
+
+  while (!text.empty()) {
+    ensure_space(1);
+
+    const auto n = std::min(text.size(), buffer.size() - used);
+
+    text.copy(buffer.data() + used, n);
+
+    used += n;
+
+    text.remove_prefix(n);
+  }
+}
+
+void TableWriter::add(double value) {
+  ensure_space(max_number_chars);
+
+  if (!row_start) {
+    buffer[used++] = separator;
+  }
+
+  const auto format = (notation == Notation::fixed) ? std::chars_format::fixed : std::chars_format::scientific;
+
+  auto* first = buffer.data() + used;
+
+  auto result = std::to_chars(first, buffer.data() + buffer.size(), value, format, precision);
+
+  if (result.ec != std::errc()) {
+    // absurdly large values in fixed notation still get written
+
+    result = std::to_chars(first, buffer.data() + buffer.size(), value, std::chars_format::scientific, precision);
+  }
+
+  used += static_cast<size_t>(result.ptr - first);
+
+  row_start = false;
+}
+
+void TableWriter::add_integer(long long value) {
+  ensure_space(max_number_chars);
+
+  if (!row_start) {
+    buffer[used++] = separator;
+  }
+
+  auto* first = buffer.data() + used;
+
+  auto result = std::to_chars(first, buffer.data() + buffer.size(), value);
+
+  used += static_cast<size_t>(result.ptr - first);
+
+  row_start = false;
+}
+
+void TableWriter::end_row() {
+  ensure_space(1);
+
+  buffer[used++] = '\n';
+
+  row_start = true;
+}
+
+void TableWriter::close() {
+  if (!file.is_open()) {
+    return;
+  }
+
+  flush_block();
+
+  if (writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> pending_lock_guard(pending_mutex);
+
+      stopping = true;
+    }
+
+    pending_cv.notify_all();
+
+    writer.join();
+  }
+
+  file.close();
+}
+
+void TableWriter::ensure_space(size_t n_chars) {
+  if (used + n_chars > buffer.size() || used >= table_block_size) {
+    flush_block();
+  }
+}
+
+void TableWriter::flush_block() {
+  if (used == 0 || !file.is_open()) {
+    return;
+  }
+
+  if (!background) {
+    file.write(buffer.data(), static_cast<std::streamsize>(used));
+
+    used = 0;
+
+    return;
+  }
+
+  // waiting for the previous block to be written before handing the next one
+
+  std::unique_lock<std::mutex> pending_lock(pending_mutex);
+
+  pending_cv.wait(pending_lock, [this]() { return !pending_full; });
+
+  std::swap(buffer, pending);
+
+  pending_size = used;
+  pending_full = true;
+
+  used = 0;
+
+  pending_lock.unlock();
+
+  pending_cv.notify_all();
+}
+
+void TableWriter::write_blocks() {
+  std::unique_lock<std::mutex> pending_lock(pending_mutex);
+
+  while (true) {
+    pending_cv.wait(pending_lock, [this]() { return stopping || pending_full; });
+
+    if (pending_full) {
+      // the producer only touches the other buffer while this one is being written
+
+      pending_lock.unlock();
+
+      file.write(pending.data(), static_cast<std::streamsize>(pending_size));
+
+      pending_lock.lock();
+
+      pending_full = false;
+
+      pending_cv.notify_all();
+    } else if (stopping) {
+      return;
+    }
+  }
+}
+
+}  // namespace util
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/*
+  Text table writer. The numbers are formatted with std::to_chars straight into a large buffer that is reused for the
+  whole file, and the buffer is written in blocks of about 1 MiB. With background set the blocks are written by a
+  second thread while the next one is being filled.
+*/
+
+class TableWriter {
+ public:
+  enum class Notation { fixed, scientific };
+
+  TableWriter(const std::filesystem::path& path,
+              int precision,
+              Notation notation = Notation::fixed,
+              char separator = '\t',
+              bool background = false);
+
+  TableWriter(const TableWriter&) = delete;
+  auto operator=(const TableWriter&) -> TableWriter& = delete;
+
+  ~TableWriter();
+
+  [[nodiscard]] auto is_open() const -> bool;
+
+  // text copied as it is. Used for headers and comments
+
+  void write(std::string_view text);
+
+  void add(double value);
+
+  void add(std::integral auto value) { add_integer(static_cast<long long>(value)); }
+
+  void end_row();
+
+  void close();
+
+ private:
+  bool row_start = true;
+  bool background = false;
+  bool stopping = false;
+  bool pending_full = false;
+
+  char separator;
+
+  int precision;
+
+  Notation notation;
+
+  size_t used = 0;
+
+  std::ofstream file;
+
+  std::vector<char> buffer;
+  std::vector<char> pending;  // block being written by the background thread
+
+  size_t pending_size = 0;
+
+  std::mutex pending_mutex;
+
+  std::condition_variable pending_cv;
+
+  std::thread writer;
+
+  void add_integer(long long value);
+  void ensure_space(size_t n_chars);
+  void flush_block();
+  void write_blocks();
+};
+
+}  // namespace util
@@ -0,0 +1,147 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace util {
+
+ThreadPool::ThreadPool(int n_threads) {
+  start(n_threads);
+}
+
+ThreadPool::~ThreadPool() {
+  join();
+}
+
+auto ThreadPool::size() const -> int {
+  return static_cast<int>(threads.size());
+}
+
+void ThreadPool::resize(int n_threads) {
+  if (n_threads == size()) {
+    return;
+  }
+
+  join();
+  start(n_threads);
+}
+
+void ThreadPool::start(int n_threads) {
+  {
+    std::lock_guard<std::mutex> tasks_lock_guard(tasks_mutex);
+
+    running = true;
+  }
+
+  for (int n = 0; n < n_threads; n++) {
+    threads.emplace_back([this]() { work(); });
+  }
+}
+
+void ThreadPool::join() {
+  {
+    std::lock_guard<std::mutex> tasks_lock_guard(tasks_mutex);
+
+    running = false;
+  }
+
+  tasks_cv.notify_all();
+
+  for (auto& t : threads) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+
+  threads.clear();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> tasks_lock(tasks_mutex);
+
+      tasks_cv.wait(tasks_lock, [this]() { return !running || !tasks.empty(); });
+
+      if (!running && tasks.empty()) {
+        return;
+      }
+
+      task = std::move(tasks.front());
+
+      tasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+void ThreadPool::parallel_for(size_t n_items, const std::function<void(size_t)>& task) {
+  const auto n_helpers = std::min(threads.size(), n_items > 0 ? n_items - 1 : 0);
+
+  if (n_helpers == 0) {
+    for (size_t n = 0; n < n_items; n++) {
+      task(n);
+    }
+
+    return;
+  }
+
+  std::atomic<size_t> next = 0;
+
+  std::exception_ptr error;
+
+  std::mutex error_mutex;
+
+  auto run = [&]() {
+    try {
+      for (size_t n = next++; n < n_items; n = next++) {
+        task(n);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> error_lock_guard(error_mutex);
+
+      error = std::current_exception();
+
+      next = n_items;  // the remaining items are abandoned
+    }
+  };
+
+  std::latch done(static_cast<std::ptrdiff_t>(n_helpers));
+
+  {
+    std::lock_guard<std::mutex> tasks_lock_guard(tasks_mutex);
+
+    for (size_t n = 0; n < n_helpers; n++) {
+      tasks.emplace_back([&]() {
+        run();
+
+        done.count_down();
+      });
+    }
+  }
+
+  tasks_cv.notify_all();
+
+  run();
+
+  done.wait();
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+auto hardware_threads() -> int {
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+}  // namespace util
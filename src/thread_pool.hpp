@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/*
+  Small fixed size pool of worker threads. In parallel_for the calling thread also takes part in the work and the
+  indices are claimed one at a time from a shared counter. So a worker that finishes a cheap item immediately steals
+  the next one instead of waiting on a static partition.
+*/
+
+class ThreadPool {
+ public:
+  explicit ThreadPool(int n_threads = 0);
+
+  ~ThreadPool();
+
+  [[nodiscard]] auto size() const -> int;
+
+  void resize(int n_threads);
+
+  void parallel_for(size_t n_items, const std::function<void(size_t)>& task);
+
+ private:
+  bool running = true;
+
+  std::deque<std::function<void()>> tasks;
+
+  std::vector<std::thread> threads;
+
+  std::mutex tasks_mutex;
+
+  std::condition_variable tasks_cv;
+
+  void start(int n_threads);
+  void join();
+  void work();
+};
+
+// Number of threads to use when the user leaves the setting at 0 (automatic)
+
+auto hardware_threads() -> int;
+
+}  // namespace util
@@ -26,28 +26,51 @@
 #include <QCameraDevice>
 #include <QMediaCaptureSession>
 #include <QMediaDevices>
+#include <QMediaMetaData>
 #include <QPainter>
+#include <QStandardPaths>
+#include <QTimer>
 #include <QVideoFrame>
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <filesystem>
 #include <format>
-#include <fstream>
-#include <iomanip>
-#include <ios>
+#include <initializer_list>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <opencv2/core/cvstd_wrapper.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
+#include <opencv2/imgproc.hpp>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "config.h"
 #include "eyeofsauron_db.h"
+#include "ffmpeg_decoder.hpp"
+#include "frame_history.hpp"
 #include "frame_source.hpp"
+#include "roi_backfill.hpp"
+#include "roi_tracker.hpp"
+#include "thread_pool.hpp"
+#include "table_writer.hpp"
+#include "trajectory_buffer.hpp"
+#include "trajectory_log.hpp"
 #include "util.hpp"
+#include "video_frame_pool.hpp"
 
 namespace tracker {
 
+// The thread calling parallel_for also updates trackers. So the pool needs one thread less than the user setting.
+
+auto helper_threads() -> int {
+  const auto n_threads = db::Main::trackerThreads();
+
+  return (n_threads == 0 ? util::hardware_threads() : n_threads) - 1;
+}
+
 Backend::Backend(QObject* parent)
     : QObject(parent),
       _frameWidth(db::Main::videoWidth()),
@@ -56,46 +79,82 @@ Backend::Backend(QObject* parent)
       camera_video_sink(std::make_unique<QVideoSink>()),
       capture_session(std::make_unique<QMediaCaptureSession>()),
       media_player(std::make_unique<QMediaPlayer>()),
-      media_player_video_sink(std::make_unique<QVideoSink>()) {
+      media_player_video_sink(std::make_unique<QVideoSink>()),
+      allocations_timer(std::make_unique<QTimer>()),
+      chart_timer(std::make_unique<QTimer>()),
+      output_frames(QVideoFrameFormat::Format_BGRX8888),
+      thread_pool(helper_threads()),
+      backfill(frame_history, [this](BackfillJob& job) { finish_backfill(job); }) {
   qmlRegisterSingletonInstance<Backend>("EoSTrackerBackend", VERSION_MAJOR, VERSION_MINOR, "EoSTrackerBackend", this);
 
   qmlRegisterSingletonInstance<SourceModel>("EosTrackerSourceModel", VERSION_MAJOR, VERSION_MINOR,
                                             "EosTrackerSourceModel", &sourceModel);
 
+  // Connected before the other handlers of these settings, so the snapshot is already updated when they run
+
+  read_settings();
+
+  for (const auto signal :
+       {&db::Main::trackingAlgorithmChanged, &db::Main::trackingResolutionChanged,
+        &db::Main::imageScalingAlgorithmChanged, &db::Main::showFpsChanged, &db::Main::showDateTimeChanged,
+        &db::Main::continuousLoggingChanged, &db::Main::nanoBackbonePathChanged, &db::Main::nanoNeckheadPathChanged,
+        &db::Main::vitModelPathChanged, &db::Main::dasiamrpnModelPathChanged, &db::Main::dasiamrpnKernelCls1PathChanged,
+        &db::Main::dasiamrpnKernelR1PathChanged, &db::Main::markerHueToleranceChanged,
+        &db::Main::markerMinSaturationChanged, &db::Main::markerMinValueChanged}) {
+    connect(db::Main::self(), signal, [this]() { read_settings(); });
+  }
+
   connect(this, &Backend::videoSinkChanged, [this]() { draw_offline_image(); });
 
-  connect(camera_video_sink.get(), &QVideoSink::videoFrameChanged, [this](const QVideoFrame& frame) {
+  pipeline = std::make_unique<FramePipeline>([this](const QVideoFrame& frame) {
     std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
 
-    if (!pause_preview && !exiting) {
-      // QMetaObject::invokeMethod(
-      //     this,
-      //     [this, frame] {
-      //       input_video_frame = frame;
-      //       process_frame();
-      //     },
-      //     Qt::QueuedConnection);
+    if (!exiting) {
       input_video_frame = frame;
       process_frame();
     }
   });
 
-  connect(media_player_video_sink.get(), &QVideoSink::videoFrameChanged, [this](const QVideoFrame& frame) {
-    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
-
+  connect(camera_video_sink.get(), &QVideoSink::videoFrameChanged, [this](const QVideoFrame& frame) {
     if (!pause_preview && !exiting) {
-      // QMetaObject::invokeMethod(
-      //     this,
-      //     [this, frame] {
-      //       input_video_frame = frame;
-      //       process_frame();
-      //     },
-      //     Qt::QueuedConnection);
-      input_video_frame = frame;
-      process_frame();
+      pipeline->push(frame);
+    }
+  });
+
+  connect(media_player_video_sink.get(), &QVideoSink::videoFrameChanged, [this](const QVideoFrame& frame) {
+    if ((!pause_preview || show_next_frame.exchange(false)) && !exiting) {
+      pipeline->push(frame);
     }
   });
 
+  // The FFmpeg decoder delivers its frames from its own thread, already scaled when the trackers work at the preview
+  // size. While paused it only sends the frames requested by seeks and steps, so they are all shown.
+
+  ffmpeg_decoder = std::make_unique<FFmpegDecoder>(
+      [this](const QVideoFrame& frame) {
+        if (!exiting) {
+          pipeline->push(frame);
+        }
+      },
+      [this](qint64 value) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, value]() {
+              _playerPosition = value;
+
+              Q_EMIT playerPositionChanged();
+            },
+            Qt::QueuedConnection);
+      });
+
+  update_decoder_output();
+
+  ffmpeg_decoder->set_cache_budget(static_cast<size_t>(db::Main::frameCacheSize()) * 1024U * 1024U);
+
+  connect(db::Main::self(), &db::Main::frameCacheSizeChanged, [this]() {
+    ffmpeg_decoder->set_cache_budget(static_cast<size_t>(db::Main::frameCacheSize()) * 1024U * 1024U);
+  });
+
   connect(media_player.get(), &QMediaPlayer::positionChanged, [this](const qint64& value) {
     _playerPosition = value;
 
@@ -113,6 +172,8 @@ Backend::Backend(QObject* parent)
 
     _frameWidth = db::Main::videoWidth();
 
+    update_decoder_output();
+
     Q_EMIT frameWidthChanged();
   });
 
@@ -121,9 +182,71 @@ Backend::Backend(QObject* parent)
 
     _frameHeight = db::Main::videoHeight();
 
+    update_decoder_output();
+
     Q_EMIT frameHeightChanged();
   });
 
+  connect(db::Main::self(), &db::Main::imageScalingAlgorithmChanged, [this]() { update_decoder_output(); });
+
+  connect(db::Main::self(), &db::Main::trackingResolutionChanged, [this]() { update_decoder_output(); });
+
+  connect(db::Main::self(), &db::Main::chartDataPointsChanged, [this]() {
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    for (auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+      trajectory.set_capacity(db::Main::chartDataPoints());
+    }
+  });
+
+  frame_history.set_capacity(static_cast<size_t>(db::Main::retrackFrames()));
+
+  connect(db::Main::self(), &db::Main::retrackFramesChanged,
+          [this]() { frame_history.set_capacity(static_cast<size_t>(db::Main::retrackFrames())); });
+
+  connect(db::Main::self(), &db::Main::trackerThreadsChanged, [this]() {
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    thread_pool.resize(helper_threads());
+  });
+
+  connect(db::Main::self(), &db::Main::continuousLoggingChanged, [this]() {
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    trajectory_log_failed = false;
+
+    if (!db::Main::continuousLogging()) {
+      close_trajectory_log();
+    }
+  });
+
+  connect(allocations_timer.get(), &QTimer::timeout, [this]() {
+    auto n_allocations = output_frames.take_allocations();
+
+    if (n_allocations != _frameAllocations) {
+      _frameAllocations = n_allocations;
+
+      Q_EMIT frameAllocationsChanged();
+    }
+
+    if (n_allocations != 0) {
+      util::debug(std::format("output video frame allocations: {0}/s", n_allocations));
+    }
+  });
+
+  connect(allocations_timer.get(), &QTimer::timeout, [this]() { update_engine_timings(); });
+
+  allocations_timer->start(1000);
+
+  // The frames only mark the chart as outdated. It is redrawn at the display rate whatever the capture rate is.
+
+  connect(chart_timer.get(), &QTimer::timeout, [this]() { refresh_chart(); });
+
+  connect(db::Main::self(), &db::Main::chartRefreshRateChanged,
+          [this]() { chart_timer->setInterval(1000 / db::Main::chartRefreshRate()); });
+
+  chart_timer->start(1000 / db::Main::chartRefreshRate());
+
   capture_session->setCamera(camera.get());
   capture_session->setVideoSink(camera_video_sink.get());
 
@@ -139,11 +262,20 @@ Backend::Backend(QObject* parent)
 Backend::~Backend() {
   camera->stop();
   media_player->stop();
+  ffmpeg_decoder->close();
+
+  pipeline->stop();
+
+  // the backfill callback takes the trackers lock. Its thread has to be joined before we hold it
+
+  backfill.stop();
 
   std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
 
   util::debug("Tracker backend exiting...");
 
+  close_trajectory_log();
+
   exiting = true;
 }
 
@@ -157,7 +289,11 @@ void Backend::start() {
       break;
     }
     case MediaFile: {
-      media_player->play();
+      if (using_ffmpeg) {
+        ffmpeg_decoder->play();
+      } else {
+        media_player->play();
+      }
       break;
     }
     case Microphone: {
@@ -174,7 +310,11 @@ void Backend::pause() {
       break;
     }
     case MediaFile: {
-      media_player->pause();
+      if (using_ffmpeg) {
+        ffmpeg_decoder->pause();
+      } else {
+        media_player->pause();
+      }
       break;
     }
     case Microphone: {
@@ -184,7 +324,15 @@ void Backend::pause() {
 }
 
 void Backend::stop() {
-  initial_time = 0;
+  {
+    // every recording session goes to its own log file
+
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    initial_time = 0;
+
+    close_trajectory_log();
+  }
 
   switch (current_source_type) {
     case Camera: {
@@ -192,7 +340,11 @@ void Backend::stop() {
       break;
     }
     case MediaFile: {
-      media_player->stop();
+      if (using_ffmpeg) {
+        ffmpeg_decoder->stop();
+      } else {
+        media_player->stop();
+      }
       break;
     }
     case Microphone: {
@@ -212,7 +364,21 @@ void Backend::selectSource(const int& index) {
 
   media_player->stop();
   camera->stop();
-  trackers.clear();
+  ffmpeg_decoder->close();
+
+  using_ffmpeg = false;
+
+  {
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    trackers.clear();
+
+    charted_revisions.clear();
+
+    last_frame_time = -1;
+  }
+
+  frame_history.clear();
 
   pause_preview = false;
 
@@ -236,7 +402,21 @@ void Backend::selectSource(const int& index) {
 
       auto url = dynamic_cast<const MediaFileSource*>(source.get())->url;
 
-      media_player->setSource(url);
+      // QMediaPlayer remains the fallback when FFmpeg is not available or cannot open the file
+
+      if (db::Main::videoDecoder() == db::Main::EnumVideoDecoder::ffmpeg) {
+        using_ffmpeg = ffmpeg_decoder->open(url.toLocalFile().toStdString());
+      }
+
+      if (using_ffmpeg) {
+        _playerPosition = 0;
+        _playerDuration = ffmpeg_decoder->duration();
+
+        Q_EMIT playerPositionChanged();
+        Q_EMIT playerDurationChanged();
+      } else {
+        media_player->setSource(url);
+      }
 
       break;
     }
@@ -287,11 +467,7 @@ void Backend::draw_offline_image() {
     util::warning("Invalid videoSink pointer!");
   }
 
-  auto video_format = QVideoFrameFormat(QSize(_frameWidth, _frameHeight), QVideoFrameFormat::Format_RGBA8888);
-
-  video_format.setColorRange(QVideoFrameFormat::ColorRange_Full);
-
-  QVideoFrame video_frame(video_format);
+  auto video_frame = output_frames.acquire(QSize(_frameWidth, _frameHeight));
 
   if (!video_frame.isValid() || !video_frame.map(QVideoFrame::WriteOnly)) {
     util::warning("QVideoFrame is not valid or not writable");
@@ -304,6 +480,8 @@ void Backend::draw_offline_image() {
   if (image_format == QImage::Format_Invalid) {
     util::warning("It is not possible to obtain image format from the pixel format of the videoframe");
 
+    video_frame.unmap();
+
     return;
   }
 
@@ -327,48 +505,73 @@ void Backend::drawRoiSelection(const bool& state) {
 void Backend::createNewRoi(double x, double y, double width, double height) {
   std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
 
-  cv::Rect2d roi = {x, y, width, height};  // region of interest that is being created
+  // the selection is drawn on the preview while the trackers work in analysis pixels
 
-  cv::Ptr<cv::legacy::Tracker> tracker;
+  const auto roi = scale_roi(cv::Rect2d(x, y, width, height), analysis_scale());
 
-  switch (db::Main::trackingAlgorithm()) {
-    case db::Main::EnumTrackingAlgorithm::mosse: {
-      tracker = cv::legacy::TrackerMOSSE::create();
-      break;
-    }
-    case db::Main::EnumTrackingAlgorithm::kcf: {
-      tracker = cv::legacy::TrackerKCF::create();
-      break;
-    }
-    case db::Main::EnumTrackingAlgorithm::tld: {
-      tracker = cv::legacy::TrackerTLD::create();
-      break;
-    }
-    case db::Main::EnumTrackingAlgorithm::mil: {
-      tracker = cv::legacy::TrackerMIL::create();
-      break;
-    }
-    default: {
-      util::warning("Unknown tracking algorithm choice!");
-      return;
-    }
+  auto tracker = create_tracker(settings.tracking_algorithm, settings.engines);
+
+  if (tracker.empty()) {
+    return;
   }
 
-  for (auto& [tracker, roi, initialized, data_tx, data_ty] : trackers) {
-    data_tx.clear();
-    data_ty.clear();
+  const bool use_color = algorithm_uses_color(settings.tracking_algorithm);
+
+  TrajectoryBuffer new_trajectory(db::Main::chartDataPoints());
+
+  new_trajectory.set_display_columns(static_cast<size_t>(chart_columns));
+
+  if (frame_history.empty()) {
+    // there is nothing to track back over. All the trajectories start again together
+
+    for (auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+      trajectory.clear();
+    }
+
+    trackers.emplace_back(RoiTracker{.tracker = tracker,
+                                     .roi = roi,
+                                     .use_color = use_color,
+                                     .trajectory = std::move(new_trajectory),
+                                     .id = next_roi_id++});
+
+    initial_time = 0;
+
+    return;
   }
 
-  trackers.emplace_back(tracker, roi, false, QList<QPointF>(), QList<QPointF>());
+  /*
+    The ROI was drawn on the last image shown. It is tracked over the history in the background while the other
+    trackers keep going. Until then a placeholder without tracker holds its place, so the chart series indices stay
+    the same.
+  */
 
-  initial_time = 0;
+  const int new_id = next_roi_id++;
+
+  trackers.emplace_back(
+      RoiTracker{.roi = roi, .use_color = use_color, .trajectory = std::move(new_trajectory), .id = new_id});
+
+  // the trajectory is built by finish_backfill in the placeholder
+
+  backfill.submit(BackfillJob{.roi_tracker = {.tracker = tracker,
+                                              .roi = roi,
+                                              .use_color = use_color,
+                                              .trajectory = TrajectoryBuffer(),
+                                              .id = new_id},
+                              .algorithm = settings.tracking_algorithm,
+                              .frame_height = analysis_size.height,
+                              .engines = settings.engines,
+                              .start_sequence = frame_history.end_sequence() - 1U});
 }
 
 void Backend::newRoiSelection(double x, double y, double width, double height) {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
   rect_selection.setRect(x, y, width, height);
 
-  if (pause_preview) {
-    process_frame();
+  if (pause_preview && input_video_frame.isValid()) {
+    // redrawing the last frame so the selection rectangle follows the mouse
+
+    pipeline->push(input_video_frame);
   }
 }
 
@@ -377,12 +580,21 @@ int Backend::removeRoi(double x, double y) {
 
   initial_time = 0;
 
+  // the click is in preview pixels
+
+  const auto scale = analysis_scale();
+
+  x *= scale.x;
+  y *= scale.y;
+
   for (size_t n = 0; n < trackers.size(); n++) {
-    const auto& [tracker, roi, initialized, data_tx, data_ty] = trackers[n];
+    const auto& [tracker, roi, initialized, use_color, trajectory, id] = trackers[n];
 
     if (x >= roi.x && x < roi.x + roi.width) {
       if (y >= roi.y && y < roi.y + roi.height) {
-        std::erase(trackers, trackers[n]);
+        charted_revisions.erase(id);
+
+        trackers.erase(trackers.begin() + static_cast<std::ptrdiff_t>(n));
 
         return n;
       }
@@ -396,6 +608,8 @@ void Backend::removeAllTrackers() {
   std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
 
   trackers.clear();
+
+  charted_revisions.clear();
 }
 
 void Backend::process_frame() {
@@ -409,17 +623,25 @@ void Backend::process_frame() {
     return;
   }
 
-  auto input_image =
-      input_video_frame.toImage()
-          .scaled(_frameWidth, _frameHeight, Qt::IgnoreAspectRatio,
-                  db::Main::imageScalingAlgorithm() == 0 ? Qt::FastTransformation : Qt::SmoothTransformation)
-          .convertedTo(QImage::Format_BGR888);
+  update_analysis_size(cv::Size(input_video_frame.width(), input_video_frame.height()));
+
+  // only the parts of the frame around the trackers are converted for them
 
-  // creating the output qvideoframe
+  tracking_windows.size = analysis_size;
+  tracking_windows.windows = search_windows(trackers, analysis_size);
+  tracking_windows.need_bgr = trackers_need_color(trackers);
+  tracking_windows.need_gray = trackers_need_gray(trackers);
+
+  if (!ingest.convert(input_video_frame, cv::Size(_frameWidth, _frameHeight),
+                      settings.nearest_scaling ? cv::INTER_NEAREST : cv::INTER_AREA, tracking_windows)) {
+    util::warning("Failed to convert the QVideoFrame");
+
+    return;
+  }
 
-  auto video_format = QVideoFrameFormat(QSize(_frameWidth, _frameHeight), QVideoFrameFormat::Format_BGRX8888);
+  // taking the output qvideoframe from the pool
 
-  QVideoFrame video_frame(video_format);
+  auto video_frame = output_frames.acquire(QSize(_frameWidth, _frameHeight));
 
   if (!video_frame.isValid() || !video_frame.map(QVideoFrame::WriteOnly)) {
     util::warning("QVideoFrame is not valid or not writable");
@@ -427,6 +649,13 @@ void Backend::process_frame() {
     return;
   }
 
+  // The converted image is written straight into the output buffer. The X byte of BGRX is ignored by the sink.
+
+  cv::Mat output_mat(video_frame.height(), video_frame.width(), CV_8UC4, video_frame.bits(0),
+                     video_frame.bytesPerLine(0));
+
+  cv::cvtColor(ingest.bgr, output_mat, cv::COLOR_BGR2BGRA);
+
   // creating the qimage that will set the output qvideoframe data
 
   QImage output_image(video_frame.bits(0), video_frame.width(), video_frame.height(),
@@ -434,6 +663,9 @@ void Backend::process_frame() {
 
   if (output_image.isNull()) {
     util::warning("The QImage is null");
+
+    video_frame.unmap();
+
     return;
   }
 
@@ -442,54 +674,73 @@ void Backend::process_frame() {
   painter.setRenderHint(QPainter::Antialiasing, true);
   painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
 
-  painter.drawImage(output_image.rect(), input_image);
+  // Stepping or seeking back in a media file brings older frames. The trackers and the trajectories start again from
+  // the frame shown, and so does the log in a new file. This way the times only grow.
+
+  if (input_video_frame.startTime() < last_frame_time) {
+    restart_tracking();
+  }
+
+  // The paused frame is pushed again to redraw the roi selection. It was already tracked, so only the overlay changes.
+
+  const bool redraw = input_video_frame.startTime() == last_frame_time;
+
+  last_frame_time = input_video_frame.startTime();
+
+  // A redrawn frame is already in the history. The same happens to the paused camera, as it only sends redraws.
+
+  if (!redraw && frame_history.enabled()) {
+    push_history(input_video_frame.startTime());
+  }
 
   if (!trackers.empty()) {
     // opencv stuff
     // https://docs.opencv.org/3.4/d3/d63/classcv_1_1Mat.html#a51615ebf17a64c968df0bf49b4de6a3a
 
-    cv::Mat cv_frame(_frameHeight, _frameWidth, CV_8UC3, input_image.bits(), input_image.bytesPerLine());
-
     initial_time = (initial_time == 0) ? input_video_frame.startTime() : initial_time;
 
-    for (auto& [tracker, roi_n, initialized, data_tx, data_ty] : trackers) {
-      if (!initialized) {
-        tracker->init(cv_frame, roi_n);
+    if (!redraw) {
+      update_trackers(trackers, ingest.tracking_bgr, ingest.tracking_gray, thread_pool, mosse_batch);
+    }
 
-        initialized = true;
-      } else {
-        tracker->update(cv_frame, roi_n);
+    const bool logging = !redraw && settings.continuous_logging && open_trajectory_log();
+
+    const double t_log = static_cast<double>(input_video_frame.startTime() - log_initial_time) / 1000000.0;
+
+    const auto scale = analysis_scale();
+
+    // The results are consumed in the order the trackers were created
+
+    for (auto& [tracker, roi_n, initialized, use_color, trajectory, id] : trackers) {
+      painter.drawRect(QRectF{roi_n.x / scale.x, roi_n.y / scale.y, roi_n.width / scale.x, roi_n.height / scale.y});
+
+      if (tracker.empty() || redraw) {
+        continue;  // finish_backfill fills the trajectory of a placeholder
       }
 
-      painter.drawRect(QRectF{roi_n.x, roi_n.y, roi_n.width, roi_n.height});
+      const auto [xc, yc] = roi_center(roi_n, analysis_size.height);
 
-      double xc = roi_n.x + (roi_n.width * 0.5);
-      double yc = roi_n.y + (roi_n.height * 0.5);
       double t = static_cast<double>(input_video_frame.startTime() - initial_time) / 1000000.0;
 
-      // changing the coordinate system origin to the bottom left corner
-
-      yc = _frameHeight - yc;
+      // the ring buffer evicts the oldest sample once it reaches chartDataPoints
 
-      data_tx.append(QPointF(t, xc));
-      data_ty.append(QPointF(t, yc));
+      trajectory.append(t, xc, yc);
 
-      while (data_tx.size() > db::Main::chartDataPoints()) {
-        data_tx.removeFirst();
-        data_ty.removeFirst();
+      if (logging) {
+        trajectory_log.append(t_log, id, xc, yc);
       }
     }
   }
 
   painter.setPen(QColorConstants::Red);
 
-  if (db::Main::showFps()) {
+  if (settings.show_fps) {
     painter.drawText(output_image.rect(), Qt::AlignLeft | Qt::AlignBottom,
                      QString::fromStdString(std::format(
                          "{0:.0f} fps", 1000000.0 / (input_video_frame.endTime() - input_video_frame.startTime()))));
   }
 
-  if (db::Main::showDateTime()) {
+  if (settings.show_date_time) {
     painter.drawText(output_image.rect(), Qt::AlignLeft | Qt::AlignTop, QDateTime::currentDateTime().toString());
   }
 
@@ -509,56 +760,258 @@ void Backend::process_frame() {
 
   _videoSink->setVideoFrame(video_frame);
 
-  if (!pause_preview) {
-    update_chart_range();
-    Q_EMIT updateChart();
+  // frames shown while paused come from seeks and frame steps. They update the chart too
+
+  chart_dirty = true;
+}
+
+void Backend::finish_backfill(BackfillJob& job) {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+  if (exiting) {
+    return;
+  }
+
+  auto placeholder = std::ranges::find_if(trackers, [&](const RoiTracker& t) { return t.id == job.roi_tracker.id; });
+
+  if (placeholder == trackers.end()) {
+    return;  // removed while it was being tracked
+  }
+
+  if (job.roi_tracker.tracker.empty()) {
+    // the tracker could not be created again after a failed job
+
+    charted_revisions.erase(placeholder->id);
+
+    trackers.erase(placeholder);
+
+    chart_dirty = true;
+
+    return;
+  }
+
+  // catching up with the images processed while the job ran. No new ones arrive while we hold the lock
+
+  backfill.track_forward(job);
+
+  // The samples are put on the time axis of the other trackers. Their times before the first sample are padded with
+  // missing values, so every trajectory has the same length.
+
+  const auto reference = std::ranges::find_if(
+      trackers, [](const RoiTracker& t) { return !t.tracker.empty() && !t.trajectory.empty(); });
+
+  if (reference == trackers.end() && !job.samples.empty()) {
+    initial_time = job.samples.front().time_us;
+  }
+
+  auto& trajectory = placeholder->trajectory;
+
+  double t_first = std::numeric_limits<double>::lowest();
+
+  if (reference != trackers.end()) {
+    t_first = reference->trajectory.t().front();
+
+    const double t_samples = job.samples.empty()
+                                 ? std::numeric_limits<double>::max()
+                                 : static_cast<double>(job.samples.front().time_us - initial_time) / 1000000.0;
+
+    for (const auto t : reference->trajectory.t()) {
+      if (t >= t_samples) {
+        break;
+      }
+
+      trajectory.append(t, std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+    }
   }
+
+  for (const auto& [time_us, xc, yc] : job.samples) {
+    const double t = static_cast<double>(time_us - initial_time) / 1000000.0;
+
+    if (t >= t_first) {
+      // older samples than the other trackers have would not be aligned with them
+
+      trajectory.append(t, xc, yc);
+    }
+  }
+
+  // the job roi is in the pixels of the history images
+
+  placeholder->roi = scale_roi(job.roi_tracker.roi, {1.0 / job.scale.x, 1.0 / job.scale.y});
+
+  if (job.scale == cv::Point2d(1.0, 1.0)) {
+    placeholder->tracker = job.roi_tracker.tracker;
+    placeholder->initialized = job.roi_tracker.initialized;
+  } else {
+    // The model learned on the reduced history images does not fit the analysis ones. A new tracker starts on the
+    // next frame from where the job left the roi, so the handover is only as precise as the history images.
+
+    placeholder->tracker = create_tracker(job.algorithm, settings.engines);
+    placeholder->initialized = false;
+  }
+
+  chart_dirty = true;
+}
+
+void Backend::push_history(qint64 time_us) {
+  /*
+    The history keeps the shape of the analysis images, but it cannot be sharper than the preview it is made from.
+    When the analysis images fit in the preview the scale is 1 and the trackers trained on the history can be used on
+    the live frames.
+  */
+
+  const double s = std::min({1.0, static_cast<double>(_frameWidth) / analysis_size.width,
+                             static_cast<double>(_frameHeight) / analysis_size.height});
+
+  const cv::Size size(std::max(cvRound(analysis_size.width * s), 1), std::max(cvRound(analysis_size.height * s), 1));
+
+  const cv::Point2d scale(static_cast<double>(size.width) / analysis_size.width,
+                          static_cast<double>(size.height) / analysis_size.height);
+
+  const cv::Mat* image = &ingest.bgr;
+
+  // Gray takes a third of the memory. The frames are converted back if the algorithm is changed to a color one.
+
+  if (!algorithm_uses_color(settings.tracking_algorithm)) {
+    cv::cvtColor(*image, history_gray, cv::COLOR_BGR2GRAY);
+
+    image = &history_gray;
+  }
+
+  if (image->size() != size) {
+    cv::resize(*image, history_image, size, 0, 0, cv::INTER_AREA);
+
+    image = &history_image;
+  }
+
+  frame_history.push(time_us, *image, scale);
 }
 
 void Backend::updateSeries(QAbstractSeries* series_x, QAbstractSeries* series_y, const int& index) {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
   if (series_x != nullptr && series_y != nullptr) {
     auto xySeries_x = dynamic_cast<QXYSeries*>(series_x);
     auto xySeries_y = dynamic_cast<QXYSeries*>(series_y);
 
-    auto& [tracker, roi_n, initialized, data_tx, data_ty] = trackers[index];
+    if (index < 0 || static_cast<size_t>(index) >= trackers.size()) {
+      return;
+    }
+
+    auto& [tracker, roi_n, initialized, use_color, trajectory, id] = trackers[index];
 
-    if (data_tx.empty() || data_ty.empty()) {
+    if (trajectory.empty()) {
       return;
     }
 
+    // at most two points per pixel column. The envelopes are kept up to date as the samples are appended
+
+    trajectory.fill_x(chart_points_x);
+    trajectory.fill_y(chart_points_y);
+
     // Use replace instead of clear + append, it's optimized for performance
-    xySeries_x->replace(data_tx);
-    xySeries_y->replace(data_ty);
+    xySeries_x->replace(chart_points_x);
+    xySeries_y->replace(chart_points_y);
   } else {
     util::warning("series_x or series_y is null!");
   }
 }
 
+void Backend::setChartWidth(int width) {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+  if (width <= 0 || width == chart_columns) {
+    return;
+  }
+
+  chart_columns = width;
+
+  for (auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    trajectory.set_display_columns(static_cast<size_t>(chart_columns));
+  }
+
+  chart_dirty = true;
+}
+
+void Backend::refresh_chart() {
+  // The chart lives in the gui thread. The ranges are updated there to avoid racing with the qml bindings.
+
+  update_pipeline_counters();
+
+  if (!chart_dirty.exchange(false)) {
+    return;
+  }
+
+  update_chart_range();
+
+  QList<bool> dirty_series;
+
+  {
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    dirty_series.reserve(static_cast<qsizetype>(trackers.size()));
+
+    for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+      auto& charted = charted_revisions[id];
+
+      dirty_series.append(trajectory.revision() != charted);
+
+      charted = trajectory.revision();
+    }
+  }
+
+  Q_EMIT updateChart(dirty_series);
+}
+
+void Backend::update_engine_timings() {
+  QString timings;
+
+  {
+    std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+    timings = QString::fromStdString(take_timing_report(trackers));
+  }
+
+  if (timings != _engineTimings) {
+    _engineTimings = timings;
+
+    Q_EMIT engineTimingsChanged();
+  }
+}
+
 void Backend::update_chart_range() {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
   double x_axis_min = 0;
   double x_axis_max = 0;
   double y_axis_min = 0;
   double y_axis_max = 0;
 
-  for (size_t n = 0; n < trackers.size(); n++) {
-    const auto& [tracker, roi, initialized, data_tx, data_ty] = trackers[n];
+  bool seeded = false;  // the first trajectory with samples sets the ranges the others widen
+
+  for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    if (trajectory.empty()) {
+      // the tracker was just created and has not processed a frame yet
+      continue;
+    }
+
+    // the ring buffer keeps its extremes up to date as samples are appended and evicted
 
-    auto [min_x, max_x] = std::ranges::minmax_element(data_tx, [](QPointF a, QPointF b) { return a.y() < b.y(); });
-    auto [min_y, max_y] = std::ranges::minmax_element(data_ty, [](QPointF a, QPointF b) { return a.y() < b.y(); });
+    auto [min_x, max_x] = trajectory.x_range();
+    auto [min_y, max_y] = trajectory.y_range();
 
     auto get_y_range = [this, min_x, min_y, max_x, max_y]() {
       double r_min = 0;
       double r_max = 0;
 
       if (_xDataVisible && _yDataVisible) {
-        r_min = std::min(min_x->y(), min_y->y());
-        r_max = std::max(max_x->y(), max_y->y());
+        r_min = std::min(min_x, min_y);
+        r_max = std::max(max_x, max_y);
       } else if (!_xDataVisible && _yDataVisible) {
-        r_min = min_y->y();
-        r_max = max_y->y();
+        r_min = min_y;
+        r_max = max_y;
       } else {
-        r_min = min_x->y();
-        r_max = max_x->y();
+        r_min = min_x;
+        r_max = max_x;
       }
 
       return std::make_pair(r_min, r_max);
@@ -566,99 +1019,302 @@ void Backend::update_chart_range() {
 
     auto r = get_y_range();
 
-    if (n == 0) {
+    // calculating the time axis range
+
+    auto [min_t, max_t] = trajectory.t_range();
+
+    if (!seeded) {
       y_axis_min = r.first;
       y_axis_max = r.second;
+
+      x_axis_min = min_t;
+      x_axis_max = max_t;
+
+      seeded = true;
     } else {
       y_axis_min = std::min(r.first, y_axis_min);
       y_axis_max = std::max(r.second, y_axis_max);
+
+      x_axis_min = std::min(min_t, x_axis_min);
+      x_axis_max = std::max(max_t, x_axis_max);
     }
+  }
 
-    // calculating the time axis range
+  // every notification makes qml relayout the chart. Only the values that moved are announced
 
-    auto [min_t, max_t] = std::ranges::minmax_element(data_tx, [](QPointF a, QPointF b) { return a.x() < b.x(); });
+  if (x_axis_min != _xAxisMin) {
+    _xAxisMin = x_axis_min;
 
-    if (n == 0) {
-      x_axis_min = min_t->x();
-      x_axis_max = max_t->x();
-    } else {
-      x_axis_min = std::min(min_t->x(), x_axis_min);
-      x_axis_max = std::max(max_t->x(), x_axis_max);
-    }
+    Q_EMIT xAxisMinChanged();
+  }
+
+  if (x_axis_max != _xAxisMax) {
+    _xAxisMax = x_axis_max;
+
+    Q_EMIT xAxisMaxChanged();
+  }
+
+  if (y_axis_min != _yAxisMin) {
+    _yAxisMin = y_axis_min;
+
+    Q_EMIT yAxisMinChanged();
   }
 
-  _xAxisMin = x_axis_min;
-  _xAxisMax = x_axis_max;
-  _yAxisMin = y_axis_min;
-  _yAxisMax = y_axis_max;
+  if (y_axis_max != _yAxisMax) {
+    _yAxisMax = y_axis_max;
 
-  Q_EMIT xAxisMinChanged();
-  Q_EMIT xAxisMaxChanged();
-  Q_EMIT yAxisMinChanged();
-  Q_EMIT yAxisMaxChanged();
+    Q_EMIT yAxisMaxChanged();
+  }
 }
 
-void Backend::saveTable(const QUrl& fileUrl) {
+auto Backend::open_trajectory_log() -> bool {
+  if (trajectory_log.is_open() && trajectory_log.failed()) {
+    // the disk is probably full. Logging stays off until the option is enabled again
+
+    close_trajectory_log();
+
+    trajectory_log_failed = true;
+
+    return false;
+  }
+
+  if (trajectory_log.is_open()) {
+    return true;
+  }
+
+  if (trajectory_log_failed) {
+    return false;
+  }
+
+  const auto file_name =
+      QDateTime::currentDateTime().toString(QStringLiteral("'trajectory_'yyyyMMdd_hhmmss'.eostraj'")).toStdString();
+
+  const auto documents = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation).toStdString();
+
+  const auto path = std::filesystem::path(documents) / file_name;
+
+  if (!trajectory_log.open(path)) {
+    trajectory_log_failed = true;
+
+    return false;
+  }
+
+  log_initial_time = input_video_frame.startTime();
+
+  util::info("Logging the trajectories to: " + path.string());
+
+  return true;
+}
+
+void Backend::close_trajectory_log() {
+  if (!trajectory_log.is_open()) {
+    return;
+  }
+
+  trajectory_log.close();
+
+  util::info("Trajectory log saved to: " + trajectory_log.path().string());
+}
+
+void Backend::update_pipeline_counters() {
+  if (auto dropped = pipeline->dropped_frames(); dropped != _droppedFrames) {
+    _droppedFrames = dropped;
+
+    Q_EMIT droppedFramesChanged();
+  }
+
+  if (auto depth = pipeline->queue_depth(); depth != _queueDepth) {
+    _queueDepth = depth;
+
+    Q_EMIT queueDepthChanged();
+  }
+}
+
+void Backend::read_settings() {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
+
+  settings = {.tracking_algorithm = db::Main::trackingAlgorithm(),
+              .tracking_resolution = db::Main::trackingResolution(),
+              .nearest_scaling = db::Main::imageScalingAlgorithm() == 0,
+              .show_fps = db::Main::showFps(),
+              .show_date_time = db::Main::showDateTime(),
+              .continuous_logging = db::Main::continuousLogging(),
+              .engines = read_engine_settings()};
+}
+
+void Backend::update_decoder_output() {
+  // Only when the trackers work at the preview size can the decoder scale the frames. Otherwise the ingest makes the
+  // preview from the native ones.
+
+  const bool preview = db::Main::trackingResolution() == db::Main::EnumTrackingResolution::preview;
+
+  ffmpeg_decoder->set_output(preview ? QSize(_frameWidth, _frameHeight) : QSize(),
+                             db::Main::imageScalingAlgorithm() == 0);
+}
+
+void Backend::update_analysis_size(const cv::Size& native_size) {
+  cv::Size size;
+
+  switch (settings.tracking_resolution) {
+    case db::Main::EnumTrackingResolution::half: {
+      size = cv::Size(std::max(native_size.width / 2, 1), std::max(native_size.height / 2, 1));
+      break;
+    }
+    case db::Main::EnumTrackingResolution::preview: {
+      size = cv::Size(_frameWidth, _frameHeight);
+      break;
+    }
+    default: {
+      size = native_size;
+      break;
+    }
+  }
+
+  if (size == analysis_size) {
+    return;
+  }
+
+  // before the first frame the ROIs are in preview pixels
+
+  const cv::Size previous = analysis_size.empty() ? cv::Size(_frameWidth, _frameHeight) : analysis_size;
+
+  const double sx = static_cast<double>(size.width) / previous.width;
+  const double sy = static_cast<double>(size.height) / previous.height;
+
+  analysis_size = size;
+
   if (trackers.empty()) {
     return;
   }
 
-  if (fileUrl.isLocalFile()) {
-    QList<QList<QPointF>> list_tx;
-    QList<QList<QPointF>> list_ty;
+  util::debug(std::format("tracking at {0}x{1}. The trackers start again from their current ROIs", size.width,
+                          size.height));
 
-    for (const auto& [tracker, roi, initialized, data_tx, data_ty] : trackers) {
-      list_tx.emplace_back(data_tx);
-      list_ty.emplace_back(data_ty);
+  // The tracker models depend on the image scale and the positions change units. So everything starts again.
+
+  for (auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    roi = cv::Rect2d(roi.x * sx, roi.y * sy, roi.width * sx, roi.height * sy);
+  }
+
+  restart_tracking();
+}
+
+void Backend::restart_tracking() {
+  for (auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    trajectory.clear();
+
+    if (tracker.empty()) {
+      continue;  // finish_backfill fills it
     }
 
-    if (list_tx[0].empty() || list_ty[0].empty()) {
-      return;
+    // A legacy tracker cannot be initialized twice. A network that cannot be loaded anymore keeps its old model.
+
+    if (auto fresh = create_tracker(tracker->algorithm(), settings.engines); !fresh.empty()) {
+      tracker = fresh;
+      initialized = false;
     }
+  }
+
+  initial_time = 0;
+
+  close_trajectory_log();
 
-    const auto N_ROWS = list_tx[0].size();
+  chart_dirty = true;
+}
 
-    std::vector<std::vector<double>> table;
+auto Backend::analysis_scale() const -> cv::Point2d {
+  if (analysis_size.empty()) {
+    return {1.0, 1.0};
+  }
 
-    for (int n = 0; n < N_ROWS; n++) {
-      std::vector<double> row;
+  return {static_cast<double>(analysis_size.width) / _frameWidth,
+          static_cast<double>(analysis_size.height) / _frameHeight};
+}
 
-      row.emplace_back(list_tx[0][n].x());  // time
+void Backend::saveTable(const QUrl& fileUrl) {
+  std::lock_guard<std::mutex> trackers_lock_guard(trackers_mutex);
 
-      for (int m = 0; m < list_tx.size(); m++) {
-        row.emplace_back(list_tx[m][n].y());  // x coord
-        row.emplace_back(list_ty[m][n].y());  // y coord
-      }
+  if (trackers.empty()) {
+    return;
+  }
+
+  if (fileUrl.isLocalFile()) {
+    // the trajectories are read in place from the ring buffers. Only the rows present in all of them are saved.
+
+    size_t n_rows = trackers[0].trajectory.size();
 
-      table.emplace_back(row);
+    for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+      n_rows = std::min(n_rows, trajectory.size());
     }
 
-    std::ofstream output_file(fileUrl.toLocalFile().toStdString());
+    if (n_rows == 0) {
+      return;
+    }
+
+    util::TableWriter table(fileUrl.toLocalFile().toStdString(), db::Main::tableFilePrecision());
 
-    output_file << std::fixed << std::setprecision(db::Main::tableFilePrecision()) << "#time";
+    table.write("#time");
 
     for (size_t k = 0; k < trackers.size(); k++) {
-      output_file << std::format("\tx{0}\ty{0}", k);
+      table.write(std::format("\tx{0}\ty{0}", k));
     }
 
-    output_file << "\n";
+    table.write("\n");
+
+    const auto time = trackers[0].trajectory.t().last(n_rows);
+
+    for (size_t n = 0; n < n_rows; n++) {
+      table.add(time[n]);
+
+      for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+        const auto offset = trajectory.size() - n_rows;
 
-    for (const auto& row : table) {
-      for (const auto& v : row) {
-        output_file << std::format("{0:.{1}f}", v, db::Main::tableFilePrecision()) << "\t";
+        table.add(trajectory.x()[offset + n]);
+        table.add(trajectory.y()[offset + n]);
       }
 
-      output_file << "\n";
+      table.end_row();
     }
 
-    output_file.close();
+    table.close();
   }
 }
 
 void Backend::setPlayerPosition(qint64 value) {
-  initial_time = 0;
+  // process_frame restarts the trajectories when the position goes back
+
+  if (using_ffmpeg) {
+    ffmpeg_decoder->seek(value);
+  } else {
+    show_next_frame = pause_preview.load();
+
+    media_player->setPosition(value);
+  }
+}
+
+void Backend::stepFrame(int n_frames) {
+  if (current_source_type != SourceType::MediaFile || !pause_preview) {
+    return;
+  }
+
+  if (using_ffmpeg) {
+    ffmpeg_decoder->step(n_frames);
+
+    return;
+  }
+
+  // QMediaPlayer can only seek by time. Moving by one frame period is the best it can do
+
+  auto frame_rate = media_player->metaData().value(QMediaMetaData::VideoFrameRate).toDouble();
+
+  if (frame_rate <= 0.0) {
+    frame_rate = 30.0;
+  }
+
+  show_next_frame = true;
 
-  media_player->setPosition(value);
+  media_player->setPosition(
+      std::max<qint64>(media_player->position() + std::llround(n_frames * 1000.0 / frame_rate), 0));
 }
 
 }  // namespace tracker
\ No newline at end of file
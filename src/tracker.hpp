@@ -3,25 +3,52 @@
 #include <qabstractseries.h>
 #include <qlist.h>
 #include <qobject.h>
+#include <qstring.h>
 #include <qpoint.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qurl.h>
 #include <QCamera>
 #include <QMediaPlayer>
+#include <QTimer>
 #include <QVideoSink>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <opencv2/core/cvstd_wrapper.hpp>
 #include <opencv2/core/types.hpp>
-#include <opencv2/tracking.hpp>
-#include <opencv2/tracking/tracking_legacy.hpp>  // IWYU pragma: export
-#include <tuple>
+#include <unordered_map>
 #include <vector>
+#include "ffmpeg_decoder.hpp"
+#include "frame_history.hpp"
+#include "frame_ingest.hpp"
+#include "frame_pipeline.hpp"
 #include "frame_source.hpp"
+#include "mosse_batch.hpp"
+#include "roi_backfill.hpp"
+#include "roi_tracker.hpp"
+#include "thread_pool.hpp"
+#include "trajectory_buffer.hpp"
+#include "trajectory_log.hpp"
+#include "video_frame_pool.hpp"
 
 namespace tracker {
 
+// Copies of the settings used by the frame pipeline and the backfill. The KConfig skeleton is not thread safe, so it is
+// only read on the gui thread when one of them changes.
+
+struct PipelineSettings {
+  int tracking_algorithm = 0;
+  int tracking_resolution = 0;
+
+  bool nearest_scaling = false;
+  bool show_fps = false;
+  bool show_date_time = false;
+  bool continuous_logging = false;
+
+  EngineSettings engines;
+};
+
 class Backend : public QObject {
   Q_OBJECT
 
@@ -49,6 +76,14 @@ class Backend : public QObject {
 
   Q_PROPERTY(QVideoSink* videoSink MEMBER _videoSink NOTIFY videoSinkChanged)
 
+  Q_PROPERTY(qint64 droppedFrames MEMBER _droppedFrames NOTIFY droppedFramesChanged)
+
+  Q_PROPERTY(int queueDepth MEMBER _queueDepth NOTIFY queueDepthChanged)
+
+  Q_PROPERTY(qint64 frameAllocations MEMBER _frameAllocations NOTIFY frameAllocationsChanged)
+
+  Q_PROPERTY(QString engineTimings MEMBER _engineTimings NOTIFY engineTimingsChanged)
+
  public:
   Backend(QObject* parent = nullptr);
 
@@ -67,6 +102,8 @@ class Backend : public QObject {
   Q_INVOKABLE void updateSeries(QAbstractSeries* series_x, QAbstractSeries* series_y, const int& index);
   Q_INVOKABLE void saveTable(const QUrl& fileUrl);
   Q_INVOKABLE void setPlayerPosition(qint64 value);
+  Q_INVOKABLE void stepFrame(int n_frames);
+  Q_INVOKABLE void setChartWidth(int width);
 
  signals:
   void videoSinkChanged();
@@ -81,36 +118,56 @@ class Backend : public QObject {
   void playerPositionChanged();
   void playerDurationChanged();
   void showPlayerSliderChanged();
-  void updateChart();
+  void droppedFramesChanged();
+  void queueDepthChanged();
+  void frameAllocationsChanged();
+  void engineTimingsChanged();
+  void updateChart(const QList<bool>& dirtySeries);  // one flag per tracker, true when its series has new data
 
  private:
   bool _xDataVisible = true;
   bool _yDataVisible = true;
   bool _showPlayerSlider = false;
-  bool draw_roi_selection = false;
-  bool pause_preview = false;
-  bool exiting = false;
+  bool using_ffmpeg = false;  // the selected media file is decoded by ffmpeg_decoder instead of media_player
+  bool trajectory_log_failed = false;  // avoids trying to create the log again on every frame
 
   int _frameWidth = 800;
   int _frameHeight = 600;
+  int _queueDepth = 0;
+  int next_roi_id = 0;
+  int chart_columns = 800;  // width of the chart plot area in pixels
 
   double _xAxisMin = 10000;
   double _xAxisMax = 0;
   double _yAxisMin = 10000;
   double _yAxisMax = 0;
 
-  qint64 initial_time = 0;
+  qint64 initial_time = 0;  // guarded by trackers_mutex
+  qint64 log_initial_time = 0;
+  qint64 last_frame_time = -1;  // start time of the last frame processed
   qint64 _playerPosition = 0;
   qint64 _playerDuration = 0;
+  qint64 _droppedFrames = 0;
+  qint64 _frameAllocations = 0;  // output frame buffers allocated in the last second
 
   SourceType current_source_type = SourceType::Camera;
 
+  // Size of the images given to the trackers. Their ROIs and trajectories are in these pixels. It is empty until the
+  // first frame arrives.
+
+  cv::Size analysis_size;
+
   QVideoSink* _videoSink = nullptr;
 
   QVideoFrame input_video_frame;
 
   QRectF rect_selection = {0.0, 0.0, 0.0, 0.0};
 
+  QString _engineTimings;  // mean update time of each tracking engine in the last second
+
+  QList<QPointF> chart_points_x;
+  QList<QPointF> chart_points_y;
+
   SourceModel sourceModel;
 
   std::unique_ptr<QCamera> camera;
@@ -118,15 +175,64 @@ class Backend : public QObject {
   std::unique_ptr<QMediaCaptureSession> capture_session;
   std::unique_ptr<QMediaPlayer> media_player;
   std::unique_ptr<QVideoSink> media_player_video_sink;
+  std::unique_ptr<QTimer> allocations_timer;
+  std::unique_ptr<QTimer> chart_timer;
+  std::unique_ptr<FramePipeline> pipeline;
+  std::unique_ptr<FFmpegDecoder> ffmpeg_decoder;
+
+  FrameIngest ingest;
 
-  std::vector<std::tuple<cv::Ptr<cv::legacy::Tracker>, cv::Rect2d, bool, QList<QPointF>, QList<QPointF>>> trackers;
+  TrackingWindows tracking_windows;
+
+  VideoFramePool output_frames;
+
+  std::vector<RoiTracker> trackers;
+
+  std::unordered_map<int, uint64_t> charted_revisions;  // trajectory revision last handed to the chart, per roi id
+
+  std::atomic<bool> chart_dirty = false;  // set by the frame pipeline, cleared by the chart timer
+
+  std::atomic<bool> show_next_frame = false;  // lets one media player frame through while paused
+
+  // written by the gui thread and read by the frame pipeline and the FFmpeg decoder threads
+
+  std::atomic<bool> draw_roi_selection = false;
+  std::atomic<bool> pause_preview = false;
+  std::atomic<bool> exiting = false;
+
+  TrajectoryLog trajectory_log;
 
   std::mutex trackers_mutex;
 
+  PipelineSettings settings;  // guarded by trackers_mutex
+
+  util::ThreadPool thread_pool;
+
+  MosseBatch mosse_batch;  // plans and buffers shared by the batched MOSSE trackers
+
+  FrameHistory frame_history;  // recent frames reduced to fit in the preview. New ROIs are tracked back over them
+
+  cv::Mat history_image;  // the preview resized to the shape of the analysis images
+  cv::Mat history_gray;
+
+  RoiBackfill backfill;  // its thread uses the members above, so it is destroyed first
+
   void find_best_camera_resolution();
   void draw_offline_image();
   void process_frame();
+  void refresh_chart();
   void update_chart_range();
+  void update_pipeline_counters();
+  void update_engine_timings();
+  void update_decoder_output();
+  void finish_backfill(BackfillJob& job);
+  void push_history(qint64 time_us);
+  void read_settings();
+  void update_analysis_size(const cv::Size& native_size);
+  void restart_tracking();
+  [[nodiscard]] auto analysis_scale() const -> cv::Point2d;
+  auto open_trajectory_log() -> bool;
+  void close_trajectory_log();
 };
 
 }  // namespace tracker
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "tracker_batch.hpp"
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <string>
+#include <vector>
+#include "mosse_batch.hpp"
+#include "roi_tracker.hpp"
+#include "table_writer.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+namespace tracker {
+
+auto track_file(const BatchOptions& options, const std::filesystem::path& file) -> bool {
+  cv::VideoCapture capture(file.string());
+
+  if (!capture.isOpened()) {
+    util::warning("Could not open the video: " + file.string());
+
+    return false;
+  }
+
+  std::vector<RoiTracker> trackers;
+
+  for (const auto& roi : options.rois) {
+    auto tracker = create_tracker(options.algorithm, options.engines);
+
+    if (tracker.empty()) {
+      return false;
+    }
+
+    trackers.emplace_back(
+        RoiTracker{.tracker = tracker, .roi = roi, .use_color = algorithm_uses_color(options.algorithm)});
+  }
+
+  auto output_path = (options.output_dir.empty() ? file.parent_path() : options.output_dir) /
+                     (file.stem().string() + "_trajectory.tsv");
+
+  util::TableWriter table(output_path, options.precision, util::TableWriter::Notation::fixed, '\t', true);
+
+  if (!table.is_open()) {
+    return false;
+  }
+
+  table.write("#time");
+
+  for (size_t k = 0; k < trackers.size(); k++) {
+    table.write(std::format("\tx{0}\ty{0}", k));
+  }
+
+  table.write("\n");
+
+  // The files are already processed in parallel. Inside each job the trackers run on the calling thread.
+
+  util::ThreadPool serial_pool(0);
+
+  MosseBatch mosse;
+
+  const bool need_gray = trackers_need_gray(trackers);
+
+  cv::Mat bgr;
+  cv::Mat gray;
+
+  double initial_time = -1;
+
+  size_t n_frames = 0;
+
+  while (capture.read(bgr)) {
+    if (need_gray) {
+      cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+    }
+
+    update_trackers(trackers, bgr, gray, serial_pool, mosse);
+
+    const double timestamp = capture.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+
+    initial_time = (initial_time < 0) ? timestamp : initial_time;
+
+    table.add(timestamp - initial_time);
+
+    for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+      const auto [xc, yc] = roi_center(roi, bgr.rows);
+
+      table.add(xc);
+      table.add(yc);
+    }
+
+    table.end_row();
+
+    n_frames++;
+  }
+
+  table.close();
+
+  // An engine that throws on these images would otherwise leave a table of frozen positions behind
+
+  for (const auto& [tracker, roi, initialized, use_color, trajectory, id] : trackers) {
+    if (tracker->has_failed()) {
+      util::warning(std::format("{}: the tracker failed. The table {} is not valid", file.string(),
+                                output_path.string()));
+
+      return false;
+    }
+  }
+
+  util::info(std::format("{}: {} frames tracked, table saved to {}", file.string(), n_frames, output_path.string()));
+
+  if (const auto report = take_timing_report(trackers); !report.empty()) {
+    util::info(std::format("{}: mean tracker update time: {}", file.string(), report));
+  }
+
+  return true;
+}
+
+auto track_files(const BatchOptions& options) -> int {
+  std::atomic<int> n_failures = 0;
+
+  util::ThreadPool pool(options.jobs - 1);
+
+  pool.parallel_for(options.files.size(), [&](size_t n) {
+    try {
+      if (!track_file(options, options.files[n])) {
+        n_failures++;
+      }
+    } catch (const cv::Exception& e) {
+      util::warning(options.files[n].string() + ": " + e.what());
+
+      n_failures++;
+    }
+  });
+
+  return n_failures;
+}
+
+}  // namespace tracker
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <opencv2/core/types.hpp>
+#include <vector>
+#include "roi_tracker.hpp"
+
+namespace tracker {
+
+struct BatchOptions {
+  int algorithm = 0;  // db::Main::EnumTrackingAlgorithm value
+
+  int jobs = 1;  // files processed at the same time
+
+  int precision = 6;
+
+  EngineSettings engines;
+
+  std::vector<cv::Rect2d> rois;  // in the pixel coordinates of the video
+
+  std::filesystem::path output_dir;  // when empty the table is written next to the video
+
+  std::vector<std::filesystem::path> files;
+};
+
+/*
+  Tracks the ROIs over every frame of each video as fast as they can be decoded. No preview is involved. For each
+  video a table named <video>_trajectory.tsv with the same columns as the ones saved by the interface is written.
+  Returns the number of files that could not be processed.
+*/
+
+auto track_files(const BatchOptions& options) -> int;
+
+}  // namespace tracker
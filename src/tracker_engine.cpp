@@ -0,0 +1,171 @@
+#include "tracker_engine.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <opencv2/core/base.hpp>
+#include <opencv2/core/cvstd_wrapper.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <span>
+#include <string>
+#include <utility>
+#include "eyeofsauron_db.h"
+#include "util.hpp"
+
+namespace tracker {
+
+// one entry per choice of trackingAlgorithm in the kcfg file
+
+// The search scales follow the windows the engines read:
+//  - KCF pads the roi by 2.5 times its size
+//  - CSRT uses a template of w + 3 sqrt(w h), about 4 roi sides, enlarged by up to 1.02^16 by its scale search
+//  - MIL samples within roi / 2 + 25 pixels of the previous position
+//  - the batched MOSSE patch is twice the roi rounded up to 32, 64 or 128 pixels, so almost 4 roi sides
+//  - the siamese networks read about 4 times the context around the roi
+
+constexpr auto engines = std::to_array<EngineInfo>({
+    {.algorithm = db::Main::EnumTrackingAlgorithm::kcf,
+     .name = "KCF",
+     .uses_color = true,
+     .cost = 3,
+     .search_scale = 4.0},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::mosse, .name = "MOSSE", .cost = 1, .search_scale = 2.0},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::tld, .name = "TLD", .uses_color = true, .cost = 30},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::mil,
+     .name = "MIL",
+     .cost = 20,
+     .search_scale = 2.0,
+     .search_padding = 25},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::csrt,
+     .name = "CSRT",
+     .uses_color = true,
+     .cost = 15,
+     .search_scale = 5.5},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::nano,
+     .name = "Nano",
+     .uses_color = true,
+     .needs_model = true,
+     .cost = 20,
+     .search_scale = 5.0},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::vit,
+     .name = "Vit",
+     .uses_color = true,
+     .needs_model = true,
+     .cost = 40,
+     .search_scale = 5.0},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::dasiamrpn,
+     .name = "DaSiamRPN",
+     .uses_color = true,
+     .needs_model = true,
+     .cost = 150,
+     .search_scale = 5.0},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::batchmosse, .name = "BatchMOSSE", .cost = 1, .search_scale = 4.0},
+    {.algorithm = db::Main::EnumTrackingAlgorithm::marker,
+     .name = "Marker",
+     .uses_color = true,
+     .cost = 1,
+     .search_scale = 3.5},
+});
+
+auto engine_infos() -> std::span<const EngineInfo> {
+  return engines;
+}
+
+auto engine_info(int algorithm) -> const EngineInfo* {
+  const auto* it = std::ranges::find(engines, algorithm, &EngineInfo::algorithm);
+
+  return it == engines.end() ? nullptr : it;
+}
+
+TrackerEngine::TrackerEngine(int algorithm) : n_algorithm(algorithm) {}
+
+void TrackerEngine::init(const cv::Mat& image, const cv::Rect2d& roi) {
+  failed = false;
+
+  try {
+    do_init(image, roi);
+  } catch (const cv::Exception& e) {
+    fail(e);
+  }
+}
+
+auto TrackerEngine::update(const cv::Mat& image, cv::Rect2d& roi) -> bool {
+  if (failed) {
+    return false;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  bool found = false;
+
+  try {
+    found = do_update(image, roi);
+  } catch (const cv::Exception& e) {
+    fail(e);
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  record_update(static_cast<uint64_t>(elapsed.count()));
+
+  return found;
+}
+
+void TrackerEngine::record_update(uint64_t ns) {
+  n_updates.fetch_add(1, std::memory_order_relaxed);
+  update_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void TrackerEngine::fail(const cv::Exception& e) {
+  failed = true;
+
+  const auto* info = engine_info(n_algorithm);
+
+  util::warning(std::string(info != nullptr ? info->name : "The") + " tracker failed and is now lost: " + e.what());
+}
+
+auto TrackerEngine::algorithm() const -> int {
+  return n_algorithm;
+}
+
+auto TrackerEngine::has_failed() const -> bool {
+  return failed;
+}
+
+auto TrackerEngine::take_timing() -> EngineTiming {
+  return {.n_updates = n_updates.exchange(0, std::memory_order_relaxed),
+          .update_ns = update_ns.exchange(0, std::memory_order_relaxed)};
+}
+
+LegacyEngine::LegacyEngine(int algorithm, cv::Ptr<cv::legacy::Tracker> tracker)
+    : TrackerEngine(algorithm), tracker(std::move(tracker)) {}
+
+void LegacyEngine::do_init(const cv::Mat& image, const cv::Rect2d& roi) {
+  tracker->init(image, roi);
+}
+
+auto LegacyEngine::do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool {
+  return tracker->update(image, roi);
+}
+
+ModernEngine::ModernEngine(int algorithm, cv::Ptr<cv::Tracker> tracker)
+    : TrackerEngine(algorithm), tracker(std::move(tracker)) {}
+
+void ModernEngine::do_init(const cv::Mat& image, const cv::Rect2d& roi) {
+  tracker->init(image, cv::Rect(roi));
+}
+
+auto ModernEngine::do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool {
+  cv::Rect box;
+
+  if (!tracker->update(image, box)) {
+    return false;
+  }
+
+  roi = box;
+
+  return true;
+}
+
+}  // namespace tracker
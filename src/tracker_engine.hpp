@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <opencv2/core/base.hpp>
+#include <opencv2/core/cvstd_wrapper.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/tracking.hpp>
+#include <opencv2/tracking/tracking_legacy.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <span>
+
+namespace tracker {
+
+/*
+  Static description of a tracking engine. The cost is the approximate time of one update relative to MOSSE on a
+  small ROI. It only gives an order of magnitude. The timings measured while tracking are the real reference.
+*/
+
+struct EngineInfo {
+  int algorithm = 0;  // db::Main::EnumTrackingAlgorithm value
+
+  const char* name = "";
+
+  bool uses_color = false;  // the engine gets the BGR image instead of the grayscale one
+
+  bool needs_model = false;  // a DNN engine whose network files are set in the preferences
+
+  int cost = 1;
+
+  // Side of the square image part read around the roi by an update, relative to the largest roi side. Zero when the
+  // engine may look at the whole frame, like the TLD detector.
+
+  double search_scale = 0.0;
+
+  int search_padding = 0;  // pixels read beyond the scaled window on each side, whatever the roi size
+};
+
+[[nodiscard]] auto engine_infos() -> std::span<const EngineInfo>;
+
+// nullptr for unknown algorithms
+
+[[nodiscard]] auto engine_info(int algorithm) -> const EngineInfo*;
+
+struct EngineTiming {
+  uint64_t n_updates = 0;
+
+  uint64_t update_ns = 0;
+};
+
+/*
+  Common interface of the OpenCV trackers. The legacy ones and the cv::Tracker ones have slightly different
+  signatures. The public methods measure the time spent in the updates. Each engine is used by one thread at a time,
+  but the timing can be taken by another one.
+*/
+
+class TrackerEngine {
+ public:
+  explicit TrackerEngine(int algorithm);
+
+  TrackerEngine(const TrackerEngine&) = delete;
+  auto operator=(const TrackerEngine&) -> TrackerEngine& = delete;
+
+  virtual ~TrackerEngine() = default;
+
+  void init(const cv::Mat& image, const cv::Rect2d& roi);
+
+  // False when the target was lost. The roi is left unchanged in that case. An OpenCV exception thrown by the engine
+  // is logged and the target stays lost until the next init.
+
+  auto update(const cv::Mat& image, cv::Rect2d& roi) -> bool;
+
+  [[nodiscard]] auto algorithm() const -> int;
+
+  // true after an OpenCV error, until the next init
+
+  [[nodiscard]] auto has_failed() const -> bool;
+
+  // for engines updated outside of update(), like the batched MOSSE filters
+
+  void record_update(uint64_t ns);
+
+  // returns the timing accumulated since the previous call
+
+  auto take_timing() -> EngineTiming;
+
+ protected:
+  virtual void do_init(const cv::Mat& image, const cv::Rect2d& roi) = 0;
+
+  virtual auto do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool = 0;
+
+ private:
+  int n_algorithm;
+
+  bool failed = false;  // set when the engine threw. Touched only by the thread using the engine
+
+  std::atomic<uint64_t> n_updates = 0;
+  std::atomic<uint64_t> update_ns = 0;
+
+  void fail(const cv::Exception& e);
+};
+
+class LegacyEngine : public TrackerEngine {
+ public:
+  LegacyEngine(int algorithm, cv::Ptr<cv::legacy::Tracker> tracker);
+
+ protected:
+  void do_init(const cv::Mat& image, const cv::Rect2d& roi) override;
+
+  auto do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool override;
+
+ private:
+  cv::Ptr<cv::legacy::Tracker> tracker;
+};
+
+// cv::Tracker works with integer rectangles. The subpixel part of the roi is lost at each update
+
+class ModernEngine : public TrackerEngine {
+ public:
+  ModernEngine(int algorithm, cv::Ptr<cv::Tracker> tracker);
+
+ protected:
+  void do_init(const cv::Mat& image, const cv::Rect2d& roi) override;
+
+  auto do_update(const cv::Mat& image, cv::Rect2d& roi) -> bool override;
+
+ private:
+  cv::Ptr<cv::Tracker> tracker;
+};
+
+}  // namespace tracker
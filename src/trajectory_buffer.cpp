@@ -0,0 +1,186 @@
+#include "trajectory_buffer.hpp"
+#include <qlist.h>
+#include <qpoint.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace tracker {
+
+TrajectoryBuffer::TrajectoryBuffer(size_t capacity)
+    : n_capacity(std::max(capacity, static_cast<size_t>(1))),
+      data_t(2 * n_capacity),
+      data_x(2 * n_capacity),
+      data_y(2 * n_capacity) {
+  envelope_x.configure(n_capacity, display_columns);
+  envelope_y.configure(n_capacity, display_columns);
+}
+
+void TrajectoryBuffer::append(double t, double x, double y) {
+  data_t[head] = data_t[head + n_capacity] = t;
+  data_x[head] = data_x[head + n_capacity] = x;
+  data_y[head] = data_y[head + n_capacity] = y;
+
+  head = (head + 1 == n_capacity) ? 0 : head + 1;
+
+  n_samples = std::min(n_samples + 1, n_capacity);
+
+  range_t.push(t);
+  range_x.push(x);
+  range_y.push(y);
+
+  range_t.keep_last(n_capacity);
+  range_x.keep_last(n_capacity);
+  range_y.keep_last(n_capacity);
+
+  envelope_x.push(t, x);
+  envelope_y.push(t, y);
+
+  n_revision++;
+}
+
+void TrajectoryBuffer::clear() {
+  n_samples = 0;
+  head = 0;
+
+  range_t.clear();
+  range_x.clear();
+  range_y.clear();
+
+  envelope_x.clear();
+  envelope_y.clear();
+
+  n_revision++;
+}
+
+void TrajectoryBuffer::set_capacity(size_t capacity) {
+  capacity = std::max(capacity, static_cast<size_t>(1));
+
+  if (capacity == n_capacity) {
+    return;
+  }
+
+  // keeping the most recent samples
+
+  const auto n_kept = std::min(n_samples, capacity);
+
+  const auto old_t = t().last(n_kept);
+  const auto old_x = x().last(n_kept);
+  const auto old_y = y().last(n_kept);
+
+  std::vector<double> new_t(2 * capacity);
+  std::vector<double> new_x(2 * capacity);
+  std::vector<double> new_y(2 * capacity);
+
+  std::ranges::copy(old_t, new_t.begin());
+  std::ranges::copy(old_x, new_x.begin());
+  std::ranges::copy(old_y, new_y.begin());
+
+  std::ranges::copy(old_t, new_t.begin() + static_cast<std::ptrdiff_t>(capacity));
+  std::ranges::copy(old_x, new_x.begin() + static_cast<std::ptrdiff_t>(capacity));
+  std::ranges::copy(old_y, new_y.begin() + static_cast<std::ptrdiff_t>(capacity));
+
+  data_t = std::move(new_t);
+  data_x = std::move(new_x);
+  data_y = std::move(new_y);
+
+  n_capacity = capacity;
+  n_samples = n_kept;
+  head = n_kept % capacity;
+
+  range_t.keep_last(n_kept);
+  range_x.keep_last(n_kept);
+  range_y.keep_last(n_kept);
+
+  rebuild_envelopes();
+}
+
+void TrajectoryBuffer::set_display_columns(size_t n_columns) {
+  n_columns = std::max(n_columns, static_cast<size_t>(1));
+
+  if (n_columns == display_columns) {
+    return;
+  }
+
+  display_columns = n_columns;
+
+  rebuild_envelopes();
+}
+
+void TrajectoryBuffer::rebuild_envelopes() {
+  envelope_x.configure(n_capacity, display_columns);
+  envelope_y.configure(n_capacity, display_columns);
+
+  // the envelopes may still hold columns of a longer window. Starting again from the stored samples is simpler
+
+  envelope_x.clear();
+  envelope_y.clear();
+
+  const auto st = t();
+  const auto sx = x();
+  const auto sy = y();
+
+  for (size_t n = 0; n < n_samples; n++) {
+    envelope_x.push(st[n], sx[n]);
+    envelope_y.push(st[n], sy[n]);
+  }
+
+  n_revision++;
+}
+
+void TrajectoryBuffer::fill_x(QList<QPointF>& points) const {
+  envelope_x.fill(points);
+}
+
+void TrajectoryBuffer::fill_y(QList<QPointF>& points) const {
+  envelope_y.fill(points);
+}
+
+auto TrajectoryBuffer::capacity() const -> size_t {
+  return n_capacity;
+}
+
+auto TrajectoryBuffer::size() const -> size_t {
+  return n_samples;
+}
+
+auto TrajectoryBuffer::empty() const -> bool {
+  return n_samples == 0;
+}
+
+auto TrajectoryBuffer::revision() const -> uint64_t {
+  return n_revision;
+}
+
+auto TrajectoryBuffer::first() const -> size_t {
+  return (head + n_capacity - n_samples) % n_capacity;
+}
+
+auto TrajectoryBuffer::t() const -> std::span<const double> {
+  return {data_t.data() + first(), n_samples};
+}
+
+auto TrajectoryBuffer::x() const -> std::span<const double> {
+  return {data_x.data() + first(), n_samples};
+}
+
+auto TrajectoryBuffer::y() const -> std::span<const double> {
+  return {data_y.data() + first(), n_samples};
+}
+
+auto TrajectoryBuffer::t_range() const -> std::pair<double, double> {
+  return {range_t.min(), range_t.max()};
+}
+
+auto TrajectoryBuffer::x_range() const -> std::pair<double, double> {
+  return {range_x.min(), range_x.max()};
+}
+
+auto TrajectoryBuffer::y_range() const -> std::pair<double, double> {
+  return {range_y.min(), range_y.max()};
+}
+
+}  // namespace tracker
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <qlist.h>
+#include <qpoint.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include "min_max_envelope.hpp"
+#include "sliding_min_max.hpp"
+
+namespace tracker {
+
+/*
+  Fixed capacity ring buffer storing the time and the coordinates of a tracker as separate arrays. Every sample is
+  written twice, at its ring position and at that position plus the capacity. Thanks to this mirror the most recent
+  samples are always contiguous in memory and can be handed out as spans in chronological order without copying.
+*/
+
+class TrajectoryBuffer {
+ public:
+  explicit TrajectoryBuffer(size_t capacity = 200);
+
+  void append(double t, double x, double y);
+
+  void clear();
+
+  void set_capacity(size_t capacity);
+
+  [[nodiscard]] auto capacity() const -> size_t;
+
+  [[nodiscard]] auto size() const -> size_t;
+
+  [[nodiscard]] auto empty() const -> bool;
+
+  // incremented whenever the stored samples change. Lets the chart skip series that were not modified
+
+  [[nodiscard]] auto revision() const -> uint64_t;
+
+  [[nodiscard]] auto t() const -> std::span<const double>;
+
+  [[nodiscard]] auto x() const -> std::span<const double>;
+
+  [[nodiscard]] auto y() const -> std::span<const double>;
+
+  // minimum and maximum of the stored samples. They are updated incrementally in append
+
+  [[nodiscard]] auto t_range() const -> std::pair<double, double>;
+
+  [[nodiscard]] auto x_range() const -> std::pair<double, double>;
+
+  [[nodiscard]] auto y_range() const -> std::pair<double, double>;
+
+  // number of pixel columns of the chart. The chart series are decimated to at most two points per column
+
+  void set_display_columns(size_t n_columns);
+
+  void fill_x(QList<QPointF>& points) const;
+
+  void fill_y(QList<QPointF>& points) const;
+
+ private:
+  size_t n_capacity;
+  size_t n_samples = 0;
+  size_t head = 0;  // ring position of the next sample
+  size_t display_columns = 800;
+
+  uint64_t n_revision = 0;
+
+  std::vector<double> data_t;
+  std::vector<double> data_x;
+  std::vector<double> data_y;
+
+  util::SlidingMinMax range_t;
+  util::SlidingMinMax range_x;
+  util::SlidingMinMax range_y;
+
+  util::MinMaxEnvelope envelope_x;
+  util::MinMaxEnvelope envelope_y;
+
+  [[nodiscard]] auto first() const -> size_t;
+
+  void rebuild_envelopes();
+};
+
+}  // namespace tracker
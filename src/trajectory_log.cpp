@@ -0,0 +1,359 @@
+#include "trajectory_log.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include "table_writer.hpp"
+#include "util.hpp"
+
+namespace tracker {
+
+constexpr std::array<char, 8> log_magic = {'E', 'O', 'S', 'T', 'R', 'A', 'J', '1'};
+
+constexpr size_t log_header_size = 16;
+
+constexpr size_t log_growth_step = 16UL * 1024UL * 1024UL;  // the file is extended 16 MiB at a time
+
+TrajectoryLog::~TrajectoryLog() {
+  close();
+}
+
+auto TrajectoryLog::open(const std::filesystem::path& path) -> bool {
+  close();
+
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0) {
+    util::warning("Could not create the trajectory log: " + path.string());
+
+    return false;
+  }
+
+  file_path = path;
+
+  if (!reserve(log_header_size)) {
+    close();
+
+    return false;
+  }
+
+  std::memcpy(map, log_magic.data(), log_magic.size());
+  std::memset(map + log_magic.size(), 0, log_header_size - log_magic.size());
+
+  file_size = log_header_size;
+
+  stopping = false;
+
+  write_failed = false;
+
+  writer = std::thread([this]() { write_blocks(); });
+
+  return true;
+}
+
+void TrajectoryLog::close() {
+  if (fd < 0) {
+    return;
+  }
+
+  if (filling.n_rows > 0) {
+    submit_block();
+  }
+
+  {
+    std::lock_guard<std::mutex> blocks_lock_guard(blocks_mutex);
+
+    stopping = true;
+  }
+
+  blocks_cv.notify_one();
+
+  if (writer.joinable()) {
+    writer.join();
+  }
+
+  if (map != nullptr) {
+    munmap(map, map_size);
+
+    map = nullptr;
+  }
+
+  // The unused part of the last extension is cut off. Everything below file_size was allocated by reserve(), so the
+  // final file has no sparse range left either.
+
+  if (ftruncate(fd, static_cast<off_t>(file_size)) != 0) {
+    util::warning("Could not set the final size of the trajectory log: " + file_path.string());
+  }
+
+  ::close(fd);
+
+  fd = -1;
+  map_size = 0;
+  file_size = 0;
+
+  full_blocks.clear();
+}
+
+auto TrajectoryLog::is_open() const -> bool {
+  return fd >= 0;
+}
+
+auto TrajectoryLog::failed() const -> bool {
+  return write_failed;
+}
+
+auto TrajectoryLog::path() const -> const std::filesystem::path& {
+  return file_path;
+}
+
+void TrajectoryLog::append(double t, int32_t roi_id, double x, double y) {
+  if (fd < 0) {
+    return;
+  }
+
+  const auto n = filling.n_rows;
+
+  filling.t[n] = t;
+  filling.roi_id[n] = roi_id;
+  filling.x[n] = x;
+  filling.y[n] = y;
+
+  filling.n_rows++;
+
+  if (filling.n_rows == block_rows) {
+    submit_block();
+  }
+}
+
+void TrajectoryLog::submit_block() {
+  {
+    std::lock_guard<std::mutex> blocks_lock_guard(blocks_mutex);
+
+    full_blocks.push_back(std::move(filling));
+
+    // Blocks already written are recycled. A new one is only allocated while the writer is behind.
+
+    if (free_blocks.empty()) {
+      filling = Block();
+    } else {
+      filling = std::move(free_blocks.back());
+
+      free_blocks.pop_back();
+    }
+  }
+
+  filling.n_rows = 0;
+
+  blocks_cv.notify_one();
+}
+
+void TrajectoryLog::write_blocks() {
+  while (true) {
+    Block block;
+
+    {
+      std::unique_lock<std::mutex> blocks_lock(blocks_mutex);
+
+      blocks_cv.wait(blocks_lock, [this]() { return stopping || !full_blocks.empty(); });
+
+      if (full_blocks.empty()) {
+        return;
+      }
+
+      block = std::move(full_blocks.front());
+
+      full_blocks.pop_front();
+    }
+
+    write_block(block);
+
+    std::lock_guard<std::mutex> blocks_lock_guard(blocks_mutex);
+
+    free_blocks.push_back(std::move(block));
+  }
+}
+
+void TrajectoryLog::write_block(const Block& block) {
+  const auto n = block.n_rows;
+
+  const auto n_bytes = sizeof(uint64_t) + (n * (3U * sizeof(double) + sizeof(int32_t)));
+
+  if (write_failed) {
+    return;
+  }
+
+  if (!reserve(file_size + n_bytes)) {
+    util::warning("The trajectory log stops here. Its remaining rows are lost: " + file_path.string());
+
+    write_failed = true;
+
+    return;
+  }
+
+  auto* p = map + file_size;
+
+  auto copy = [&](const void* src, size_t size) {
+    std::memcpy(p, src, size);
+
+    p += size;
+  };
+
+  const auto n_rows = static_cast<uint64_t>(n);
+
+  copy(&n_rows, sizeof(n_rows));
+  copy(block.t.data(), n * sizeof(double));
+  copy(block.roi_id.data(), n * sizeof(int32_t));
+  copy(block.x.data(), n * sizeof(double));
+  copy(block.y.data(), n * sizeof(double));
+
+  file_size += n_bytes;
+}
+
+auto TrajectoryLog::reserve(size_t n_bytes) -> bool {
+  if (n_bytes <= map_size) {
+    return true;
+  }
+
+  const auto new_size = ((n_bytes / log_growth_step) + 1U) * log_growth_step;
+
+  // The blocks are written through the mapping, where a full disk raises SIGBUS instead of returning an error. So
+  // the space is allocated here, which also extends the file. ftruncate would leave the new range sparse.
+
+  if (const int err = posix_fallocate(fd, static_cast<off_t>(map_size), static_cast<off_t>(new_size - map_size));
+      err != 0) {
+    util::warning("Could not extend the trajectory log: " + file_path.string() + ": " + std::strerror(err));
+
+    return false;
+  }
+
+  void* new_map = (map == nullptr) ? mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                   : mremap(map, map_size, new_size, MREMAP_MAYMOVE);
+
+  if (new_map == MAP_FAILED) {
+    util::warning("Could not map the trajectory log: " + file_path.string());
+
+    return false;
+  }
+
+  map = static_cast<uint8_t*>(new_map);
+  map_size = new_size;
+
+  return true;
+}
+
+auto convert_trajectory_log(const std::filesystem::path& input,
+                            const std::filesystem::path& output,
+                            char separator,
+                            int precision) -> bool {
+  const int fd = ::open(input.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    util::warning("Could not open the trajectory log: " + input.string());
+
+    return false;
+  }
+
+  struct stat file_stat {};
+
+  fstat(fd, &file_stat);
+
+  const auto size = static_cast<size_t>(file_stat.st_size);
+
+  void* data = (size >= log_header_size) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+
+  ::close(fd);
+
+  if (data == MAP_FAILED || std::memcmp(data, log_magic.data(), log_magic.size()) != 0) {
+    util::warning("Not a trajectory log: " + input.string());
+
+    if (data != MAP_FAILED) {
+      munmap(data, size);
+    }
+
+    return false;
+  }
+
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  const auto bytes = std::span<const uint8_t>(static_cast<const uint8_t*>(data), size);
+
+  util::TableWriter table(output, precision, util::TableWriter::Notation::fixed, separator, true);
+
+  if (!table.is_open()) {
+    munmap(data, size);
+
+    return false;
+  }
+
+  const auto sep = std::string(1, separator);
+
+  table.write((separator == ',' ? "time" : "#time") + sep + "roi" + sep + "x" + sep + "y\n");
+
+  size_t offset = log_header_size;
+
+  bool ok = true;
+
+  std::vector<double> t;
+  std::vector<int32_t> roi_id;
+  std::vector<double> x;
+  std::vector<double> y;
+
+  auto read = [&](void* dst, size_t n_bytes) {
+    std::memcpy(dst, bytes.data() + offset, n_bytes);
+
+    offset += n_bytes;
+  };
+
+  while (offset + sizeof(uint64_t) <= bytes.size()) {
+    uint64_t n_rows = 0;
+
+    read(&n_rows, sizeof(n_rows));
+
+    const auto n = static_cast<size_t>(n_rows);
+
+    if (n > (bytes.size() - offset) / (3U * sizeof(double) + sizeof(int32_t))) {
+      util::warning("The trajectory log is truncated: " + input.string());
+
+      ok = false;
+
+      break;
+    }
+
+    t.resize(n);
+    roi_id.resize(n);
+    x.resize(n);
+    y.resize(n);
+
+    read(t.data(), n * sizeof(double));
+    read(roi_id.data(), n * sizeof(int32_t));
+    read(x.data(), n * sizeof(double));
+    read(y.data(), n * sizeof(double));
+
+    for (size_t k = 0; k < n; k++) {
+      table.add(t[k]);
+      table.add(roi_id[k]);
+      table.add(x[k]);
+      table.add(y[k]);
+      table.end_row();
+    }
+  }
+
+  munmap(data, size);
+
+  table.close();
+
+  return ok;
+}
+
+}  // namespace tracker
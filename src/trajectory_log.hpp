@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tracker {
+
+/*
+  Continuous log of every tracked sample. The file is a 16 bytes header ("EOSTRAJ1" followed by 8 reserved bytes) and
+  a sequence of blocks. Each block starts with its number of rows as an uint64 followed by the columns time (double),
+  roi id (int32), x (double) and y (double), in this order and in native byte order.
+
+  append() only fills the current block in memory. Full blocks are handed to a background thread that copies them to
+  the memory mapped file. So the frame thread never waits for the disk.
+*/
+
+class TrajectoryLog {
+ public:
+  TrajectoryLog() = default;
+  TrajectoryLog(const TrajectoryLog&) = delete;
+  auto operator=(const TrajectoryLog&) -> TrajectoryLog& = delete;
+
+  ~TrajectoryLog();
+
+  auto open(const std::filesystem::path& path) -> bool;
+
+  void close();
+
+  [[nodiscard]] auto is_open() const -> bool;
+
+  [[nodiscard]] auto path() const -> const std::filesystem::path&;
+
+  void append(double t, int32_t roi_id, double x, double y);
+
+  // true once a block could not be written. The writer drops the following ones, so the log should be closed
+
+  [[nodiscard]] auto failed() const -> bool;
+
+  static constexpr size_t block_rows = 4096;
+
+ private:
+  struct Block {
+    size_t n_rows = 0;
+
+    std::vector<double> t = std::vector<double>(block_rows);
+    std::vector<int32_t> roi_id = std::vector<int32_t>(block_rows);
+    std::vector<double> x = std::vector<double>(block_rows);
+    std::vector<double> y = std::vector<double>(block_rows);
+  };
+
+  bool stopping = false;
+
+  std::atomic<bool> write_failed = false;
+
+  int fd = -1;
+
+  size_t map_size = 0;
+  size_t file_size = 0;
+
+  uint8_t* map = nullptr;
+
+  std::filesystem::path file_path;
+
+  Block filling;
+
+  std::deque<Block> full_blocks;
+  std::vector<Block> free_blocks;
+
+  std::mutex blocks_mutex;
+
+  std::condition_variable blocks_cv;
+
+  std::thread writer;
+
+  void submit_block();
+  void write_blocks();
+  void write_block(const Block& block);
+  auto reserve(size_t n_bytes) -> bool;
+};
+
+/*
+  Converts a trajectory log to a text table in long format with the columns time, roi, x and y. The separator is
+  usually '\t' or ','.
+*/
+
+auto convert_trajectory_log(const std::filesystem::path& input,
+                            const std::filesystem::path& output,
+                            char separator,
+                            int precision) -> bool;
+
+}  // namespace tracker
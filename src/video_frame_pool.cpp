@@ -0,0 +1,117 @@
+#include "video_frame_pool.hpp"
+#include <qsize.h>
+#include <qtpreprocessorsupport.h>
+#include <qtversionchecks.h>
+#include <qtypes.h>
+#include <qvideoframeformat.h>
+#include <QVideoFrame>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+#include <QAbstractVideoBuffer>
+#endif
+
+namespace tracker {
+
+namespace {
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+
+class PooledBuffer : public QAbstractVideoBuffer {
+ public:
+  PooledBuffer(QVideoFrameFormat format, std::vector<uchar> data, std::shared_ptr<VideoFramePool::FreeBuffers> pool)
+      : frame_format(std::move(format)), data(std::move(data)), pool(std::move(pool)) {}
+
+  PooledBuffer(const PooledBuffer&) = delete;
+  auto operator=(const PooledBuffer&) -> PooledBuffer& = delete;
+
+  // called when the last frame using the buffer is destroyed, possibly in the render thread
+
+  ~PooledBuffer() override {
+    std::lock_guard<std::mutex> buffers_lock_guard(pool->buffers_mutex);
+
+    if (pool->frame_size == frame_format.frameSize() && pool->buffers.size() < pool->max_buffers) {
+      pool->buffers.push_back(std::move(data));
+    }
+  }
+
+  auto map(QVideoFrame::MapMode mode) -> MapData override {
+    Q_UNUSED(mode);
+
+    MapData map_data;
+
+    map_data.planeCount = 1;
+    map_data.bytesPerLine[0] = frame_format.frameWidth() * 4;
+    map_data.data[0] = data.data();
+    map_data.dataSize[0] = static_cast<int>(data.size());
+
+    return map_data;
+  }
+
+  [[nodiscard]] auto format() const -> QVideoFrameFormat override { return frame_format; }
+
+ private:
+  QVideoFrameFormat frame_format;
+
+  std::vector<uchar> data;
+
+  std::shared_ptr<VideoFramePool::FreeBuffers> pool;
+};
+
+#endif
+
+}  // namespace
+
+VideoFramePool::VideoFramePool(QVideoFrameFormat::PixelFormat pixel_format, size_t n_frames)
+    : pixel_format(pixel_format), free_buffers(std::make_shared<FreeBuffers>()) {
+  free_buffers->max_buffers = std::max(n_frames, static_cast<size_t>(1));
+}
+
+auto VideoFramePool::acquire(const QSize& size) -> QVideoFrame {
+  auto video_format = QVideoFrameFormat(size, pixel_format);
+
+  video_format.setColorRange(QVideoFrameFormat::ColorRange_Full);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+  std::vector<uchar> data;
+
+  {
+    std::lock_guard<std::mutex> buffers_lock_guard(free_buffers->buffers_mutex);
+
+    if (size != free_buffers->frame_size) {
+      free_buffers->buffers.clear();  // the buffers still in use are dropped when they come back
+
+      free_buffers->frame_size = size;
+    }
+
+    if (!free_buffers->buffers.empty()) {
+      data = std::move(free_buffers->buffers.back());
+
+      free_buffers->buffers.pop_back();
+    }
+  }
+
+  if (data.empty()) {
+    data.resize(static_cast<size_t>(size.width()) * static_cast<size_t>(size.height()) * 4U);
+
+    n_allocations++;
+  }
+
+  return QVideoFrame(std::make_unique<PooledBuffer>(video_format, std::move(data), free_buffers));
+#else
+  n_allocations++;
+
+  return QVideoFrame(video_format);
+#endif
+}
+
+auto VideoFramePool::take_allocations() -> qint64 {
+  return n_allocations.exchange(0);
+}
+
+}  // namespace tracker
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <qsize.h>
+#include <qtypes.h>
+#include <qvideoframeformat.h>
+#include <QVideoFrame>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tracker {
+
+/*
+  Recycles the pixel buffers of the output frames instead of allocating a new QVideoFrame for every preview update.
+  A buffer only goes back to the pool when the last QVideoFrame using it is destroyed. So a frame the video sink or
+  the render thread still holds is never written again. The buffers are reallocated when the requested size changes
+  or when more frames than usual are in flight. Only single plane formats with 4 bytes per pixel are supported.
+
+  Before Qt 6.8 a QVideoFrame cannot own a custom buffer. Then every frame is allocated.
+*/
+
+class VideoFramePool {
+ public:
+  explicit VideoFramePool(QVideoFrameFormat::PixelFormat pixel_format, size_t n_frames = 4);
+
+  auto acquire(const QSize& size) -> QVideoFrame;
+
+  auto take_allocations() -> qint64;
+
+  // Buffers not used by any frame. They are shared with the frames, which may outlive the pool inside the sink.
+
+  struct FreeBuffers {
+    size_t max_buffers = 0;
+
+    QSize frame_size;
+
+    std::vector<std::vector<uchar>> buffers;
+
+    std::mutex buffers_mutex;
+  };
+
+ private:
+  std::atomic<qint64> n_allocations = 0;
+
+  QVideoFrameFormat::PixelFormat pixel_format;
+
+  std::shared_ptr<FreeBuffers> free_buffers;
+};
+
+}  // namespace tracker
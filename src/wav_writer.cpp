@@ -0,0 +1,195 @@
+#include "wav_writer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ios>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "util.hpp"
+
+namespace sound {
+
+constexpr uint32_t wav_header_size = 58;  // riff + fmt + fact + data chunk headers
+
+WavWriter::~WavWriter() {
+  close();
+}
+
+auto WavWriter::open(const std::filesystem::path& path, int sampling_rate) -> bool {
+  close();
+
+  file.open(path, std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open()) {
+    util::warning("Could not create the audio recording: " + path.string());
+
+    return false;
+  }
+
+  file_path = path;
+
+  rate = sampling_rate;
+
+  n_written = 0;
+
+  // the sizes are fixed in close()
+
+  write_header(rate, 0);
+
+  filling.reserve(block_samples);
+
+  stopping = false;
+
+  writer = std::thread([this]() { write_blocks(); });
+
+  return true;
+}
+
+void WavWriter::close() {
+  if (!file.is_open()) {
+    return;
+  }
+
+  if (!filling.empty()) {
+    submit_block();
+  }
+
+  {
+    std::lock_guard<std::mutex> blocks_lock_guard(blocks_mutex);
+
+    stopping = true;
+  }
+
+  blocks_cv.notify_one();
+
+  if (writer.joinable()) {
+    writer.join();
+  }
+
+  write_header(rate, n_written);
+
+  file.close();
+}
+
+auto WavWriter::is_open() const -> bool {
+  return file.is_open();
+}
+
+auto WavWriter::path() const -> const std::filesystem::path& {
+  return file_path;
+}
+
+void WavWriter::append(std::span<const float> samples) {
+  if (!file.is_open()) {
+    return;
+  }
+
+  while (!samples.empty()) {
+    const auto n = std::min(samples.size(), block_samples - filling.size());
+
+    filling.insert(filling.end(), samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(n));
+
+    samples = samples.subspan(n);
+
+    if (filling.size() == block_samples) {
+      submit_block();
+    }
+  }
+}
+
+void WavWriter::submit_block() {
+  {
+    std::lock_guard<std::mutex> blocks_lock_guard(blocks_mutex);
+
+    full_blocks.push_back(std::move(filling));
+
+    if (free_blocks.empty()) {
+      filling = std::vector<float>();
+    } else {
+      filling = std::move(free_blocks.back());
+
+      free_blocks.pop_back();
+    }
+  }
+
+  filling.clear();
+  filling.reserve(block_samples);
+
+  blocks_cv.notify_one();
+}
+
+void WavWriter::write_blocks() {
+  while (true) {
+    std::vector<std::vector<float>> blocks;
+
+    {
+      std::unique_lock<std::mutex> blocks_lock(blocks_mutex);
+
+      blocks_cv.wait(blocks_lock, [this]() { return stopping || !full_blocks.empty(); });
+
+      if (full_blocks.empty()) {
+        return;
+      }
+
+      std::swap(blocks, full_blocks);
+    }
+
+    for (const auto& block : blocks) {
+      file.write(std::bit_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size() * sizeof(float)));
+
+      n_written += block.size();
+    }
+
+    std::lock_guard<std::mutex> blocks_lock_guard(blocks_mutex);
+
+    for (auto& block : blocks) {
+      free_blocks.push_back(std::move(block));
+    }
+  }
+}
+
+void WavWriter::write_header(int sampling_rate, uint64_t n_samples) {
+  // https://www.mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+  // Files bigger than 4 GiB can not describe their size. The fields are saturated and most readers still cope.
+
+  const auto data_size = static_cast<uint32_t>(
+      std::min<uint64_t>(n_samples * sizeof(float), std::numeric_limits<uint32_t>::max() - wav_header_size));
+
+  auto put_u32 = [&](uint32_t v) { file.write(std::bit_cast<const char*>(&v), sizeof(v)); };
+  auto put_u16 = [&](uint16_t v) { file.write(std::bit_cast<const char*>(&v), sizeof(v)); };
+
+  file.seekp(0);
+
+  file.write("RIFF", 4);
+  put_u32(wav_header_size - 8U + data_size);
+  file.write("WAVE", 4);
+
+  file.write("fmt ", 4);
+  put_u32(18);
+  put_u16(3);  // WAVE_FORMAT_IEEE_FLOAT
+  put_u16(1);  // mono
+  put_u32(static_cast<uint32_t>(sampling_rate));
+  put_u32(static_cast<uint32_t>(sampling_rate) * sizeof(float));
+  put_u16(sizeof(float));
+  put_u16(32);
+  put_u16(0);  // no extension
+
+  // non PCM formats need the fact chunk
+
+  file.write("fact", 4);
+  put_u32(4);
+  put_u32(static_cast<uint32_t>(std::min<uint64_t>(n_samples, std::numeric_limits<uint32_t>::max())));
+
+  file.write("data", 4);
+  put_u32(data_size);
+
+  file.seekp(0, std::ios::end);
+}
+
+}  // namespace sound
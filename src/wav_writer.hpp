@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace sound {
+
+/*
+  Records mono 32 bits float samples to a WAV file. The samples are collected in blocks that a background thread
+  writes to the disk, so append() never waits for it. The sizes in the header are written when the file is closed.
+*/
+
+class WavWriter {
+ public:
+  WavWriter() = default;
+  WavWriter(const WavWriter&) = delete;
+  auto operator=(const WavWriter&) -> WavWriter& = delete;
+
+  ~WavWriter();
+
+  auto open(const std::filesystem::path& path, int sampling_rate) -> bool;
+
+  void close();
+
+  [[nodiscard]] auto is_open() const -> bool;
+
+  [[nodiscard]] auto path() const -> const std::filesystem::path&;
+
+  void append(std::span<const float> samples);
+
+  static constexpr size_t block_samples = 65536;
+
+ private:
+  bool stopping = false;
+
+  int rate = 0;
+
+  uint64_t n_written = 0;  // samples already in the file
+
+  std::filesystem::path file_path;
+
+  std::ofstream file;
+
+  std::vector<float> filling;
+
+  std::vector<std::vector<float>> full_blocks;
+  std::vector<std::vector<float>> free_blocks;
+
+  std::mutex blocks_mutex;
+
+  std::condition_variable blocks_cv;
+
+  std::thread writer;
+
+  void submit_block();
+  void write_blocks();
+  void write_header(int sampling_rate, uint64_t n_samples);
+};
+
+}  // namespace sound